@@ -21,12 +21,24 @@ include_directories(${rosserial_arduino_PACKAGE_PATH}/src/ros_lib)
 rosbuild_invoke_rospack(${PROJECT_NAME} ${PROJECT_NAME} "depedencies" "depends")
 string(REGEX REPLACE "\n" ";" ${PROJECT_NAME}_depedencies ${${PROJECT_NAME}_depedencies})
 
+#set ROSSERIAL_ARRAY_LIMITS to a make_library.py array limits file before
+#including this script to generate fixed-capacity, allocation-free arrays
+set(MAKE_LIBRARY_ARGS)
+if (ROSSERIAL_ARRAY_LIMITS)
+  set(MAKE_LIBRARY_ARGS --array-limits=${ROSSERIAL_ARRAY_LIMITS})
+endif()
+#set ROSSERIAL_TARGET to arm32 or host for boards with native 64-bit double
+#and integer support; the default, avr, narrows float64 and int64 fields
+if (ROSSERIAL_TARGET)
+  list(APPEND MAKE_LIBRARY_ARGS --target=${ROSSERIAL_TARGET})
+endif()
+
 foreach(MSG_PKG ${${PROJECT_NAME}_depedencies})
         rosbuild_find_ros_package(${MSG_PKG})
   if (EXISTS ${${MSG_PKG}_PACKAGE_PATH}/msg AND
     NOT EXISTS ${PROJECT_SOURCE_DIR}/msg_gen/${MSG_PKG})
     message(STATUS "Generating rosserial implementation for ${MSG_PKG} in ${PROJECT_SOURCE_DIR}/src" )
-    execute_process(COMMAND rosrun rosserial_client make_library.py ${PROJECT_SOURCE_DIR}/msg_gen ${MSG_PKG} OUTPUT_QUIET)
+    execute_process(COMMAND rosrun rosserial_client make_library.py ${MAKE_LIBRARY_ARGS} ${PROJECT_SOURCE_DIR}/msg_gen ${MSG_PKG} OUTPUT_QUIET)
   endif()
 endforeach(MSG_PKG)
 FILE(GLOB_RECURSE ROS_MSG_GEN ${PROJECT_SOURCE_DIR}/msg_gen/*)
@@ -44,9 +44,13 @@
 
 #include "ros/hardware.h"
 
-class ArduinoHardware : public ros::Hardware {
+// BaseT is ros::Hardware for the run-time bound ArduinoHardware, or
+// ros::StaticHardware for StaticArduinoHardware, which NodeHandle_ calls
+// without going through a vtable.
+template<class BaseT>
+class ArduinoHardware_ : public BaseT {
  public:
-  ArduinoHardware(HardwareSerial* iostream=&Serial, long baud=115200)
+  ArduinoHardware_(HardwareSerial* iostream=&Serial, long baud=115200)
       : iostream_(iostream), baud_(baud) {}
 
   void setBaud(long baud) {
@@ -65,20 +69,51 @@ class ArduinoHardware : public ros::Hardware {
     return iostream_->read();
   }
 
+  int read(uint8_t* buffer, int max) {
+    int count = iostream_->available();
+    if (count > max) {
+      count = max;
+    }
+    for (int i = 0; i < count; i++) {
+      buffer[i] = iostream_->read();
+    }
+    return count;
+  }
+
+  int available() {
+    return iostream_->available();
+  }
+
   void write(uint8_t* data, int length) {
     iostream_->write(data, length);
   }
 
+  int availableForWrite() {
+#if defined(ARDUINO) && ARDUINO >= 10606
+    return iostream_->availableForWrite();
+#else
+    // Older cores cannot report free space in the transmit buffer.
+    return -1;
+#endif
+  }
+
   unsigned long time() const {
     return millis();
   }
 
+  unsigned long timeMicros() const {
+    return micros();
+  }
+
  private:
   long baud_;
   HardwareSerial* iostream_;
 
-  ArduinoHardware(const ArduinoHardware&);
-  void operator=(const ArduinoHardware&);
+  ArduinoHardware_(const ArduinoHardware_&);
+  void operator=(const ArduinoHardware_&);
 };
 
+typedef ArduinoHardware_<ros::Hardware> ArduinoHardware;
+typedef ArduinoHardware_<ros::StaticHardware> StaticArduinoHardware;
+
 #endif  // ROS_ARDUINO_HARDWARE_H_
@@ -22,10 +22,17 @@ char warn[] = "warnings";
 char error[] = "errors";
 char fatal[] = "fatalities";
 
+// Binary log formats stay in flash and are sent to the host once; each
+// message only carries the format number and the raw arguments.
+const char uptime_format[] ROSSERIAL_PROGMEM = "up for %lu ms";
+const char* const log_formats[] = { uptime_format };
+enum { LOG_UPTIME };
+
 void setup()
 {
   pinMode(13, OUTPUT);
   nh.initNode();
+  nh.setLogFormats(log_formats, 1);
   nh.advertise(chatter);
 }
 
@@ -39,6 +46,7 @@ void loop()
   nh.logwarn(warn);
   nh.logerror(error);
   nh.logfatal(fatal);
+  nh.logBinary<rosserial_msgs::Log::INFO>(LOG_UPTIME, millis());
   
   nh.spinOnce();
   delay(500);
@@ -11,7 +11,7 @@ ros::NodeHandle  nh;
 #include <tf/transform_broadcaster.h>
 
 geometry_msgs::TransformStamped t;
-tf::TransformBroadcaster broadcaster;
+tf::TransformBroadcaster broadcaster(nh);
 
 char base_link[] = "/base_link";
 char odom[] = "/odom";
@@ -0,0 +1,287 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROS_UART_HARDWARE_H_
+#define ROS_UART_HARDWARE_H_
+
+#if !defined(__AVR__)
+#error "UartHardware drives AVR USARTs directly; use ArduinoHardware on other targets."
+#endif
+
+#include <string.h>
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#if defined(ARDUINO) && ARDUINO >= 100
+#include <Arduino.h>
+#else
+#include <WProgram.h>
+#endif
+
+#include "ros/hardware.h"
+
+// Registers of one AVR USART.
+struct UartRegisters {
+  volatile uint8_t* ubrrh;
+  volatile uint8_t* ubrrl;
+  volatile uint8_t* ucsra;
+  volatile uint8_t* ucsrb;
+  volatile uint8_t* ucsrc;
+  volatile uint8_t* udr;
+};
+
+inline UartRegisters makeUartRegisters(
+    volatile uint8_t* ubrrh, volatile uint8_t* ubrrl, volatile uint8_t* ucsra,
+    volatile uint8_t* ucsrb, volatile uint8_t* ucsrc, volatile uint8_t* udr) {
+  UartRegisters registers = { ubrrh, ubrrl, ucsra, ucsrb, ucsrc, udr };
+  return registers;
+}
+
+// Registers of USART n, e.g. ROSSERIAL_UART_REGISTERS(1) for the port
+// behind Serial1 on a Mega.
+#define ROSSERIAL_UART_REGISTERS(n) \
+  makeUartRegisters(&UBRR##n##H, &UBRR##n##L, &UCSR##n##A, &UCSR##n##B, \
+                    &UCSR##n##C, &UDR##n)
+
+// Defines the receive complete and data register empty interrupt handlers
+// of a USART and routes them to hardware, a global UartHardware_. vector is
+// the prefix of the vector names: USART on an ATmega328P, USART0 to USART3
+// on an ATmega2560. The USART must not also be used through HardwareSerial,
+// which defines the same handlers.
+#define ROSSERIAL_UART_ISR(vector, hardware) \
+  ISR(vector##_RX_vect) { (hardware).receiveInterrupt(); } \
+  ISR(vector##_UDRE_vect) { (hardware).transmitInterrupt(); }
+
+template<bool kSmall> struct UartIndex { typedef uint8_t Type; };
+template<> struct UartIndex<false> { typedef uint16_t Type; };
+
+// Drives a USART through interrupt-fed ring buffers of kRxSize and kTxSize
+// bytes, which must be powers of two of at most 16384. HardwareSerial only
+// buffers 64 bytes, which arrive in 0.6 ms at 1 Mbaud; a ring holding the
+// input of a whole loop() lets high baud rates work with realistic loop
+// times. Bytes that arrive while the receive ring is full are dropped and
+// counted. Like ArduinoHardware_, BaseT selects run-time or compile-time
+// binding to NodeHandle_.
+//
+//   UartHardware_<ros::StaticHardware, 1024> hardware(
+//       ROSSERIAL_UART_REGISTERS(0), 1000000);
+//   ROSSERIAL_UART_ISR(USART0, hardware)
+template<class BaseT, int kRxSize = 256, int kTxSize = 64>
+class UartHardware_ : public BaseT {
+ public:
+  UartHardware_(const UartRegisters& registers, long baud=115200)
+      : registers_(registers), baud_(baud), rx_head_(0), rx_tail_(0),
+        tx_head_(0), tx_tail_(0), rx_overrun_count_(0) {}
+
+  void setBaud(long baud) {
+    baud_ = baud;
+  }
+
+  int getBaud() const {
+    return baud_;
+  }
+
+  void init() {
+    // Double speed mode keeps the baud rate error low at high rates, e.g.
+    // 1 Mbaud is exact at 16 MHz.
+    uint16_t setting = (F_CPU / 4 / baud_ - 1) / 2;
+    *registers_.ucsrb = 0;
+    *registers_.ucsra = 1 << U2X0;
+    *registers_.ubrrh = setting >> 8;
+    *registers_.ubrrl = setting;
+    *registers_.ucsrc = (1 << UCSZ01) | (1 << UCSZ00);
+    *registers_.ucsrb = (1 << RXEN0) | (1 << TXEN0) | (1 << RXCIE0);
+  }
+
+  int read() {
+    Index tail = rx_tail_;
+    if (tail == load(&rx_head_)) {
+      return -1;
+    }
+    uint8_t value = rx_buffer_[tail];
+    store(&rx_tail_, (tail + 1) & (kRxSize - 1));
+    return value;
+  }
+
+  int read(uint8_t* buffer, int max) {
+    Index tail = rx_tail_;
+    int count = (load(&rx_head_) - tail) & (kRxSize - 1);
+    if (count > max) {
+      count = max;
+    }
+    int span = kRxSize - tail;
+    if (span > count) {
+      span = count;
+    }
+    memcpy(buffer, rx_buffer_ + tail, span);
+    memcpy(buffer + span, rx_buffer_, count - span);
+    store(&rx_tail_, (tail + count) & (kRxSize - 1));
+    return count;
+  }
+
+  int available() {
+    return (load(&rx_head_) - rx_tail_) & (kRxSize - 1);
+  }
+
+  // Queues data for the transmit interrupt, waiting for space if the ring
+  // is full.
+  void write(uint8_t* data, int length) {
+    while (length > 0) {
+      Index head = tx_head_;
+      int count = (load(&tx_tail_) - head - 1) & (kTxSize - 1);
+      if (count == 0) {
+        // With interrupts disabled nothing drains the ring, so feed the
+        // USART by polling.
+        if (!(SREG & (1 << SREG_I)) && (*registers_.ucsra & (1 << UDRE0))) {
+          transmitInterrupt();
+        }
+        continue;
+      }
+      if (count > length) {
+        count = length;
+      }
+      int span = kTxSize - head;
+      if (span > count) {
+        span = count;
+      }
+      memcpy(tx_buffer_ + head, data, span);
+      memcpy(tx_buffer_, data + span, count - span);
+      // UCSRnB is memory mapped, so |= is a load and a store; were the
+      // interrupt to drain the ring and clear UDRIE in between, this
+      // would set it again with nothing queued.
+      uint8_t sreg = SREG;
+      cli();
+      tx_head_ = (head + count) & (kTxSize - 1);
+      *registers_.ucsrb |= 1 << UDRIE0;
+      SREG = sreg;
+      data += count;
+      length -= count;
+    }
+  }
+
+  int availableForWrite() {
+    return (load(&tx_tail_) - tx_head_ - 1) & (kTxSize - 1);
+  }
+
+  unsigned long time() const {
+    return millis();
+  }
+
+  unsigned long timeMicros() const {
+    return micros();
+  }
+
+  // Bytes lost because the receive ring was full or the receive interrupt
+  // was serviced too late.
+  unsigned int getRxOverrunCount() const {
+    return load(&rx_overrun_count_);
+  }
+
+  // Called by the handlers ROSSERIAL_UART_ISR defines.
+  void receiveInterrupt() {
+    bool overrun = *registers_.ucsra & (1 << DOR0);
+    uint8_t value = *registers_.udr;
+    Index head = rx_head_;
+    Index next = (head + 1) & (kRxSize - 1);
+    if (next == rx_tail_) {
+      overrun = true;
+    } else {
+      rx_buffer_[head] = value;
+      rx_head_ = next;
+    }
+    if (overrun) {
+      rx_overrun_count_++;
+    }
+  }
+
+  void transmitInterrupt() {
+    Index tail = tx_tail_;
+    if (tail == tx_head_) {
+      // Nothing queued; don't send a stale byte or pass the head.
+      *registers_.ucsrb &= ~(1 << UDRIE0);
+      return;
+    }
+    *registers_.udr = tx_buffer_[tail];
+    tail = (tail + 1) & (kTxSize - 1);
+    tx_tail_ = tail;
+    if (tail == tx_head_) {
+      *registers_.ucsrb &= ~(1 << UDRIE0);
+    }
+  }
+
+ private:
+  typedef typename UartIndex<(kRxSize <= 256 && kTxSize <= 256)>::Type Index;
+  typedef char SizesMustBePowersOfTwo[
+      ((kRxSize & (kRxSize - 1)) == 0 && (kTxSize & (kTxSize - 1)) == 0 &&
+       kRxSize <= 16384 && kTxSize <= 16384) ? 1 : -1];
+
+  UartRegisters registers_;
+  long baud_;
+  // The interrupts advance rx_head_ and tx_tail_, the main loop rx_tail_
+  // and tx_head_. One slot of each ring stays empty to tell full from empty.
+  volatile Index rx_head_;
+  volatile Index rx_tail_;
+  volatile Index tx_head_;
+  volatile Index tx_tail_;
+  volatile unsigned int rx_overrun_count_;
+  uint8_t rx_buffer_[kRxSize];
+  uint8_t tx_buffer_[kTxSize];
+
+  // Accesses a variable shared with the interrupts, which may take more
+  // than one instruction. Masking interrupts also stops the compiler from
+  // moving buffer accesses across it.
+  template<class T>
+  static T load(const volatile T* variable) {
+    uint8_t sreg = SREG;
+    cli();
+    T value = *variable;
+    SREG = sreg;
+    return value;
+  }
+
+  static void store(volatile Index* variable, Index value) {
+    uint8_t sreg = SREG;
+    cli();
+    *variable = value;
+    SREG = sreg;
+  }
+
+  UartHardware_(const UartHardware_&);
+  void operator=(const UartHardware_&);
+};
+
+typedef UartHardware_<ros::Hardware> UartHardware;
+typedef UartHardware_<ros::StaticHardware> StaticUartHardware;
+
+#endif  // ROS_UART_HARDWARE_H_
@@ -0,0 +1,76 @@
+/*
+ * rosserial client core benchmark
+ * Runs the loopback benchmarks of rosserial_client/benchmark and prints
+ * CPU cycles per frame on the serial port at 115200 baud. No host node is
+ * needed; the client core talks to itself through an in-memory ring.
+ */
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include <Arduino.h>
+#else
+#include <WProgram.h>
+#endif  // Arduino 1.0+
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+#include "client_benchmark.h"
+
+// Timer1 counts CPU cycles; its overflows extend the count to 32 bits,
+// which wrap after four and a half minutes at 16 MHz. Timer0 still runs
+// millis(), so every case includes its interrupt, as a real firmware would.
+volatile unsigned long timer1_overflows = 0;
+
+ISR(TIMER1_OVF_vect) {
+  timer1_overflows++;
+}
+
+unsigned long cycles() {
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t count = TCNT1;
+  unsigned long overflows = timer1_overflows;
+  // An overflow that is pending but not counted yet.
+  if ((TIFR1 & _BV(TOV1)) && count < 0x8000) {
+    overflows++;
+  }
+  SREG = sreg;
+  return (overflows << 16) | count;
+}
+
+void report(const benchmark::Result& result) {
+  Serial.print(result.message);
+  Serial.print(' ');
+  Serial.print(result.operation);
+  if (result.frames == 0 || result.ticks == 0) {
+    Serial.println(" failed");
+    return;
+  }
+  Serial.print(' ');
+  Serial.print(result.ticks / result.frames);
+  if (result.bytes == 0) {
+    Serial.println(" cycles/call");
+    return;
+  }
+  double seconds = static_cast<double>(result.ticks) / F_CPU;
+  Serial.print(" cycles/frame ");
+  Serial.print(result.frames / seconds, 0);
+  Serial.print(" frames/s ");
+  Serial.print(result.bytes / seconds, 0);
+  Serial.println(" bytes/s");
+}
+
+void setup() {
+  Serial.begin(115200);
+  TCCR1A = 0;
+  TCCR1B = _BV(CS10);  // No prescaler: one count per cycle.
+  TCNT1 = 0;
+  TIMSK1 = _BV(TOIE1);
+  sei();
+  Serial.println("rosserial client benchmark");
+  Serial.flush();
+  benchmark::runBenchmarks(cycles, report);
+}
+
+void loop() {
+}
@@ -0,0 +1,70 @@
+/*
+ * rosserial Service Test
+ * Calls its own service through the host: the client calls "length",
+ * which the host forwards back to the server, keeping several calls in
+ * flight. The LED toggles for every answered call.
+ */
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include <Arduino.h>
+#else
+#include <WProgram.h>
+#endif  // Arduino 1.0+
+
+#include "arduino_hardware.h"
+#include "ros/node_handle.h"
+#include "ros/service_client.h"
+#include "ros/service_server.h"
+
+#include "rosserial_msgs/RequestParam.h"
+
+using rosserial_msgs::RequestParamRequest;
+using rosserial_msgs::RequestParamResponse;
+
+ArduinoHardware hardware;
+ros::NodeHandle nh(&hardware);
+
+int32_t length;
+
+void serve(const RequestParamRequest& req, RequestParamResponse& resp) {
+  length = strlen(req.name);
+  resp.ints_length = 1;
+  resp.ints = &length;
+}
+
+ros::ServiceServer<RequestParamRequest, RequestParamResponse> server("length", &serve);
+
+int pending = 0;
+
+void answered(int request_id, bool success, const RequestParamResponse& resp) {
+  pending--;
+  if (success) {
+    digitalWrite(13, HIGH - digitalRead(13));
+  } else {
+    nh.logwarn("length call failed");
+  }
+}
+
+ros::ServiceClient<RequestParamRequest, RequestParamResponse> client("length", &answered);
+
+RequestParamRequest req;
+
+void setup() {
+  pinMode(13, OUTPUT);
+  hardware.init();
+  nh.advertiseService(server);
+  nh.serviceClient(client);
+  req.name = const_cast<char*>("rosserial");
+}
+
+void loop() {
+  // Calls outstanding when the connection drops are never answered.
+  if (!nh.connected()) {
+    pending = 0;
+  }
+  if (nh.connected() && pending < 4 && client.call(req) >= 0) {
+    pending++;
+  }
+  nh.spinOnce();
+  delay(10);
+}
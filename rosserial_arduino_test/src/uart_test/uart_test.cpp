@@ -0,0 +1,61 @@
+/*
+ * rosserial UartHardware Test
+ * Sums an array at 1 Mbaud while loop() is busy for 10 ms; run the host
+ * with _baud:=1000000.
+ */
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include <Arduino.h>
+#else
+#include <WProgram.h>
+#endif  // Arduino 1.0+
+
+#include "uart_hardware.h"
+#include "ros/node_handle.h"
+#include "ros/publisher.h"
+#include "ros/subscriber.h"
+
+#include "geometry_msgs/Pose.h"
+#include "geometry_msgs/PoseArray.h"
+
+// 10 ms of input at 1 Mbaud is 1000 bytes.
+typedef UartHardware_<ros::StaticHardware, 1024, 128> Hardware;
+
+Hardware hardware(ROSSERIAL_UART_REGISTERS(0), 1000000);
+ROSSERIAL_UART_ISR(USART0, hardware)
+ros::NodeHandle_<Hardware> node_handle(&hardware);
+
+geometry_msgs::Pose sum_msg;
+ros::Publisher publisher("sum", &sum_msg);
+
+void callback(const geometry_msgs::PoseArray& msg) {
+  sum_msg.position.x = 0;
+  sum_msg.position.y = 0;
+  sum_msg.position.z = 0;
+  for(int i = 0; i < msg.poses_length; i++) {
+    sum_msg.position.x += msg.poses[i].position.x;
+    sum_msg.position.y += msg.poses[i].position.y;
+    sum_msg.position.z += msg.poses[i].position.z;
+  }
+  publisher.publish(&sum_msg);
+}
+
+ros::Subscriber<geometry_msgs::PoseArray> subscriber(
+    "poses", &callback);
+
+unsigned int overrun_count = 0;
+
+void setup() {
+  hardware.init();
+  node_handle.subscribe(subscriber);
+  node_handle.advertise(publisher);
+}
+
+void loop() {
+  node_handle.spinOnce();
+  if (hardware.getRxOverrunCount() != overrun_count) {
+    overrun_count = hardware.getRxOverrunCount();
+    node_handle.logwarn("receive ring overrun");
+  }
+  delay(10);
+}
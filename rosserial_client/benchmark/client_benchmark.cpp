@@ -0,0 +1,77 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Times the client core on the host, through a loopback Hardware:
+//
+//   rosrun rosserial_client client_benchmark
+//
+// The same cases run on an Arduino Mega as the client_benchmark firmware
+// of rosserial_arduino_test, which reports CPU cycles instead of time.
+
+#include <stdio.h>
+#include <time.h>
+
+#include "client_benchmark.h"
+
+namespace {
+
+unsigned long nanoseconds() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000ul + now.tv_nsec;
+}
+
+void report(const benchmark::Result& result) {
+  if (result.frames == 0 || result.ticks == 0) {
+    printf("%-22s %-12s failed\n", result.message, result.operation);
+    return;
+  }
+  if (result.bytes == 0) {
+    printf("%-22s %-12s %10.1f ns/call\n", result.message, result.operation,
+           static_cast<double>(result.ticks) / result.frames);
+    return;
+  }
+  double seconds = result.ticks * 1e-9;
+  printf("%-22s %-12s %10.1f ns/frame %12.0f frames/s %10.2f MB/s\n",
+         result.message, result.operation,
+         static_cast<double>(result.ticks) / result.frames,
+         result.frames / seconds, result.bytes / seconds / 1e6);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  benchmark::runBenchmarks(nanoseconds, report);
+  return 0;
+}
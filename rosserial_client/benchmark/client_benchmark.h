@@ -0,0 +1,375 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSSERIAL_BENCHMARK_CLIENT_BENCHMARK_H_
+#define ROSSERIAL_BENCHMARK_CLIENT_BENCHMARK_H_
+
+#include <string.h>
+
+#include "ros/clock_model.h"
+#include "ros/duration.h"
+#include "ros/node_handle.h"
+#include "ros/node_output.h"
+#include "ros/publisher.h"
+#include "ros/subscriber.h"
+
+#include "geometry_msgs/TransformStamped.h"
+#include "sensor_msgs/LaserScan.h"
+#include "std_msgs/String.h"
+#include "tf/tfMessage.h"
+
+#include "loopback_hardware.h"
+
+// Loopback benchmarks of the client core, shared by the host benchmark and
+// the AVR firmware in rosserial_arduino_test. Each case times one
+// operation on a representative message and hands the totals to a
+// reporter, which turns clock ticks into rates for its platform.
+
+namespace benchmark {
+
+#if defined(__AVR__)
+const int kIterations = 200;
+const int kScanPoints = 48;
+const int kFrameSize = 512;
+const int kRingSize = 1024;
+#else
+const int kIterations = 20000;
+const int kScanPoints = 180;
+const int kFrameSize = 2048;
+const int kRingSize = 16384;
+#endif
+const int kTransforms = 4;
+
+typedef LoopbackHardware<kRingSize> BenchmarkHardware;
+typedef ros::NodeHandle_<BenchmarkHardware, 1, 1, kFrameSize, kFrameSize> BenchmarkNodeHandle;
+
+// Ticks of the platform's clock. Differences must be exact across one
+// case, so the clock may wrap but not within a case.
+typedef unsigned long (*ClockFunction)();
+
+struct Result {
+  const char* message;
+  const char* operation;
+  unsigned long frames;
+  // Bytes serialized, or framed bytes for publish and spinOnce. 0 for
+  // cases that time calls rather than frames.
+  unsigned long bytes;
+  unsigned long ticks;
+};
+
+typedef void (*ReportFunction)(const Result& result);
+
+// The messages timed, filled in as a typical node would.
+class Messages {
+ public:
+  std_msgs::String string;
+  sensor_msgs::LaserScan scan;
+  tf::tfMessage tf;
+
+  Messages() {
+    string.data = const_cast<char*>("rosserial loopback benchmark 01");
+
+    fillHeader(&scan.header, "base_laser");
+    scan.angle_min = -1.57f;
+    scan.angle_max = 1.57f;
+    scan.angle_increment = 3.14f / kScanPoints;
+    scan.time_increment = 0.0001f;
+    scan.scan_time = 0.1f;
+    scan.range_min = 0.02f;
+    scan.range_max = 5.6f;
+    for (int i = 0; i < kScanPoints; i++) {
+      ranges_[i] = 0.5f + 0.01f * i;
+      intensities_[i] = i;
+    }
+    scan.ranges_length = kScanPoints;
+    scan.ranges = ranges_;
+    scan.intensities_length = kScanPoints;
+    scan.intensities = intensities_;
+
+    static const char* kChildFrames[kTransforms] = {
+      "base_link", "base_laser", "imu_link", "camera_link"
+    };
+    for (int i = 0; i < kTransforms; i++) {
+      geometry_msgs::Transform& transform = transforms_[i].transform;
+      fillHeader(&transforms_[i].header, i == 0 ? "odom" : "base_link");
+      transforms_[i].child_frame_id = const_cast<char*>(kChildFrames[i]);
+      transform.translation.x = 0.1 * i;
+      transform.translation.y = -0.05 * i;
+      transform.translation.z = 0.2;
+      transform.rotation.x = 0.0;
+      transform.rotation.y = 0.0;
+      transform.rotation.z = 0.38268;
+      transform.rotation.w = 0.92388;
+    }
+    tf.transforms_length = kTransforms;
+    tf.transforms = transforms_;
+  }
+
+ private:
+  float ranges_[kScanPoints];
+  float intensities_[kScanPoints];
+  geometry_msgs::TransformStamped transforms_[kTransforms];
+
+  static void fillHeader(std_msgs::Header* header, const char* frame_id) {
+    header->seq = 1234;
+    header->stamp = ros::Time(1300000000ul, 500000000ul);
+    header->frame_id = const_cast<char*>(frame_id);
+  }
+
+  Messages(const Messages&);
+  void operator=(const Messages&);
+};
+
+template<class MsgT>
+void consume(const MsgT& msg) {}
+
+// Generated messages leave their members uninitialized, so the messages
+// that are deserialized into live in static storage, where their array
+// pointers start out null. Static members of a template rather than
+// function statics, which would need __cxa_guard_acquire() on AVR.
+template<class MsgT>
+struct Received {
+  static MsgT message;
+  static ros::Subscriber<MsgT> subscriber;
+};
+
+template<class MsgT>
+MsgT Received<MsgT>::message;
+
+template<class MsgT>
+ros::Subscriber<MsgT> Received<MsgT>::subscriber("benchmark", &consume<MsgT>);
+
+// Two frames' worth of bytes shared by the cases.
+inline unsigned char* scratchBuffer() {
+  static unsigned char buffer[2 * kFrameSize];
+  return buffer;
+}
+
+// Msg::serialize() into a buffer.
+template<class MsgT>
+void benchmarkSerialize(const char* name, MsgT* msg, ClockFunction clock,
+                        ReportFunction report) {
+  unsigned char* buffer = scratchBuffer();
+  Result result = {name, "serialize", kIterations, 0, 0};
+  unsigned long start = clock();
+  for (int i = 0; i < kIterations; i++) {
+    int length = msg->serialize(buffer, kFrameSize);
+    if (length < 0) {
+      result.frames = 0;
+      break;
+    }
+    result.bytes += length;
+  }
+  result.ticks = clock() - start;
+  report(result);
+}
+
+// Msg::deserialize() from a serialized copy of msg. Strings are decoded
+// in place, overwriting their length, so the time includes copying the
+// serialized bytes back before each call.
+template<class MsgT>
+void benchmarkDeserialize(const char* name, MsgT* msg, ClockFunction clock,
+                          ReportFunction report) {
+  unsigned char* serialized = scratchBuffer();
+  unsigned char* buffer = serialized + kFrameSize;
+  int length = msg->serialize(serialized, kFrameSize);
+  MsgT* copy = &Received<MsgT>::message;
+  Result result = {name, "deserialize", kIterations, 0, 0};
+  unsigned long start = clock();
+  for (int i = 0; i < kIterations; i++) {
+    memcpy(buffer, serialized, length);
+    int decoded = copy->deserialize(buffer, length);
+    if (decoded != length) {
+      result.frames = 0;
+      break;
+    }
+    result.bytes += decoded;
+  }
+  result.ticks = clock() - start;
+  report(result);
+}
+
+// Publisher::publish(), down to the hardware write.
+template<class MsgT>
+void benchmarkPublish(const char* name, MsgT* msg, ClockFunction clock,
+                      ReportFunction report) {
+  BenchmarkHardware hardware;
+  BenchmarkNodeHandle nh(&hardware);
+  ros::Publisher publisher("benchmark", msg);
+  nh.advertise(publisher);
+  int frame_length = msg->serializedLength() + 7;
+  Result result = {name, "publish", kIterations, 0, 0};
+  unsigned long start = clock();
+  for (int i = 0; i < kIterations; i++) {
+    if (hardware.availableForWrite() < frame_length) {
+      hardware.clear();
+    }
+    if (publisher.publish(msg) < 0) {
+      result.frames = 0;
+      break;
+    }
+  }
+  result.ticks = clock() - start;
+  result.bytes = static_cast<unsigned long>(frame_length) * kIterations;
+  report(result);
+}
+
+// NodeHandle::spinOnce() parsing frames of msg and handing each to a
+// subscriber, which deserializes it. The ring is refilled between rounds,
+// outside the timed part.
+template<class MsgT>
+void benchmarkSpinOnce(const char* name, MsgT* msg, ClockFunction clock,
+                       ReportFunction report) {
+  BenchmarkHardware hardware;
+  BenchmarkNodeHandle nh(&hardware);
+  nh.subscribe(Received<MsgT>::subscriber);
+  // Writes frames as the host would, with the subscriber's topic ID.
+  ros::NodeOutput_<BenchmarkHardware, kFrameSize> host(&hardware);
+  int frame_length = msg->serializedLength() + 7;
+  Result result = {name, "spinOnce", 0, 0, 0};
+  while (result.frames < static_cast<unsigned long>(kIterations)) {
+    int frames = 0;
+    while (hardware.availableForWrite() >= frame_length &&
+           result.frames + frames < static_cast<unsigned long>(kIterations)) {
+      host.publish(100, msg);
+      ++frames;
+    }
+    unsigned long start = clock();
+    while (nh.spinOnce() > 0) {}
+    result.ticks += clock() - start;
+    result.frames += frames;
+  }
+  result.bytes = static_cast<unsigned long>(frame_length) * result.frames;
+  if (nh.getChecksumErrorCount() != 0 || nh.getMalformedMessageErrorCount() != 0) {
+    result.frames = 0;
+  }
+  report(result);
+}
+
+template<class MsgT>
+void benchmarkMessage(const char* name, MsgT* msg, ClockFunction clock,
+                      ReportFunction report) {
+  benchmarkSerialize(name, msg, clock, report);
+  benchmarkDeserialize(name, msg, clock, report);
+  benchmarkPublish(name, msg, clock, report);
+  benchmarkSpinOnce(name, msg, clock, report);
+}
+
+// Time and Duration arithmetic, which every stamp and NodeHandle::now()
+// goes through. Each case reports kIterations calls as frames. Inputs
+// change every iteration and results go to a volatile, so that neither
+// is folded away.
+inline void benchmarkTime(ClockFunction clock, ReportFunction report) {
+  volatile unsigned long sink = 0;
+  ros::Time time(1300000000ul, 500000000ul);
+  ros::Duration step(0, 270000001l);
+  Result result = {"ros/Time", "+= Duration", kIterations, 0, 0};
+  unsigned long start = clock();
+  for (int i = 0; i < kIterations; i++) {
+    time += step;
+    sink = time.nsec;
+  }
+  result.ticks = clock() - start;
+  report(result);
+
+  result.operation = "-= Duration";
+  start = clock();
+  for (int i = 0; i < kIterations; i++) {
+    time -= step;
+    sink = time.nsec;
+  }
+  result.ticks = clock() - start;
+  report(result);
+
+  result.operation = "Time(s, ns)";
+  start = clock();
+  for (int i = 0; i < kIterations; i++) {
+    ros::Time constructed(1300000000ul + i, i * 4999ul);
+    sink = constructed.nsec;
+  }
+  result.ticks = clock() - start;
+  report(result);
+
+  result.operation = "fromSec";
+  start = clock();
+  for (int i = 0; i < kIterations; i++) {
+    sink = ros::Time::fromSec(1000.0f + 0.37f * i).nsec;
+  }
+  result.ticks = clock() - start;
+  report(result);
+
+  result.message = "ros/Duration";
+  result.operation = "fromMillis";
+  start = clock();
+  for (int i = 0; i < kIterations; i++) {
+    sink = ros::Duration::fromMillis(7l * i).nsec;
+  }
+  result.ticks = clock() - start;
+  report(result);
+
+  result.operation = "fromMicros";
+  start = clock();
+  for (int i = 0; i < kIterations; i++) {
+    sink = ros::Duration::fromMicros(7001l * i).nsec;
+  }
+  result.ticks = clock() - start;
+  report(result);
+
+  // Synced from two round trips a second apart, as after the first syncs.
+  ros::ClockModel model;
+  model.update(1000000ul, ros::Time(1300000000ul, 0), 1002000ul);
+  model.update(2000000ul, ros::Time(1300000001ul, 0), 2002000ul);
+  result.message = "ros/ClockModel";
+  result.operation = "toHostTime";
+  start = clock();
+  for (int i = 0; i < kIterations; i++) {
+    sink = model.toHostTime(2500000ul + 997ul * i).nsec;
+  }
+  result.ticks = clock() - start;
+  report(result);
+  (void) sink;
+}
+
+// Runs every case. A result with no frames means the case failed.
+inline void runBenchmarks(ClockFunction clock, ReportFunction report) {
+  Messages messages;
+  benchmarkMessage("std_msgs/String", &messages.string, clock, report);
+  benchmarkMessage("sensor_msgs/LaserScan", &messages.scan, clock, report);
+  benchmarkMessage("tf/tfMessage", &messages.tf, clock, report);
+  benchmarkTime(clock, report);
+}
+
+}  // namespace benchmark
+
+#endif  // ROSSERIAL_BENCHMARK_CLIENT_BENCHMARK_H_
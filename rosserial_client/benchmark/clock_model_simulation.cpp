@@ -0,0 +1,160 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Simulates time sync round trips through ros::ClockModel, and through
+// the offset-only scheme NodeHandle_::now() used before it, on a link
+// with a clock 80 ppm slow, 2.5-3.5 ms of jitter on each leg and a 40 ms
+// delay on every 7th reply:
+//
+//   rosrun rosserial_client clock_model_simulation
+//
+// Prints the worst now() error of both between syncs for several sync
+// periods, and exits with 1 if ClockModel is off by 1 ms or more, its
+// skew estimate is off by 7 ppm or more, it accepts a delayed reply or it
+// doesn't adopt a link that stays slower.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ros/clock_model.h"
+#include "ros/duration.h"
+#include "ros/time.h"
+
+namespace {
+
+const double kSkewPpm = 80;
+const int kRoundTrips = 60;
+// Round trips before errors count, while the model settles.
+const int kSettleRoundTrips = 3;
+const int kDelayedReplyEvery = 7;
+
+// Host time is 1000 s ahead of real time, local time a slow microsecond
+// counter.
+double hostAt(double real) {
+  return 1000 + real;
+}
+
+unsigned long localAt(double real) {
+  return static_cast<unsigned long>(real * 1e6 * (1 - kSkewPpm * 1e-6) + 12345);
+}
+
+ros::Time toTime(double seconds) {
+  unsigned long sec = static_cast<unsigned long>(seconds);
+  return ros::Time(sec, static_cast<unsigned long>((seconds - sec) * 1e9));
+}
+
+double error(const ros::Time& time, double truth) {
+  return fabs(time.sec + time.nsec * 1e-9 - truth);
+}
+
+// One leg of a round trip, in seconds.
+double leg() {
+  return 0.0025 + (rand() % 1000) * 1e-6;
+}
+
+struct Result {
+  double worst;
+  double worst_old;
+  double skew_ppm;
+  bool rejects_delayed_replies;
+  bool adopts_slower_link;
+};
+
+Result simulate(double period) {
+  srand(1);
+  ros::ClockModel model;
+  Result result = {0, 0, 0, true, false};
+  double real = 1;
+  for (int k = 0; k < kRoundTrips; k++) {
+    double sent = real;
+    double stamped = sent + leg();
+    double received = stamped + leg();
+    bool delayed = k % kDelayedReplyEvery == kDelayedReplyEvery - 1;
+    if (delayed) {
+      received += 0.04;
+    }
+    if (model.update(localAt(sent), toTime(hostAt(stamped)), localAt(received)) && delayed) {
+      result.rejects_delayed_replies = false;
+    }
+    // The old scheme: half the round trip in milliseconds, then
+    // milliseconds since the reply.
+    unsigned long sent_ms = localAt(sent) / 1000;
+    unsigned long received_ms = localAt(received) / 1000;
+    ros::Time synced = toTime(hostAt(stamped)) +
+                       ros::Duration::fromMillis((received_ms - sent_ms) / 2);
+    for (double since = 0.01; since < period; since += period / 10) {
+      double now = received + since;
+      if (k < kSettleRoundTrips) {
+        continue;
+      }
+      double e = error(model.toHostTime(localAt(now)), hostAt(now));
+      if (e > result.worst) {
+        result.worst = e;
+      }
+      ros::Duration elapsed = ros::Duration::fromMillis(localAt(now) / 1000 - received_ms);
+      e = error(synced + elapsed, hostAt(now));
+      if (e > result.worst_old) {
+        result.worst_old = e;
+      }
+    }
+    real = received + period;
+  }
+  result.skew_ppm = model.getSkew() * 1e6;
+  // The link turns 50 ms slower for good.
+  for (int k = 0; k < 5; k++) {
+    model.update(localAt(real), toTime(hostAt(real + 0.025)), localAt(real + 0.05));
+    real += 1;
+  }
+  result.adopts_slower_link = model.getRoundTripTime() > 40000;
+  return result;
+}
+
+}  // namespace
+
+int main() {
+  static const double kPeriods[] = {5, 60, 300};
+  bool ok = true;
+  printf(" period | ClockModel | old scheme | skew\n");
+  for (unsigned int i = 0; i < sizeof(kPeriods) / sizeof(kPeriods[0]); i++) {
+    Result result = simulate(kPeriods[i]);
+    printf("%5.0f s | %7.2f ms | %7.2f ms | %5.1f ppm%s%s\n", kPeriods[i],
+           result.worst * 1e3, result.worst_old * 1e3, result.skew_ppm,
+           result.rejects_delayed_replies ? "" : ", delayed reply accepted",
+           result.adopts_slower_link ? "" : ", slower link not adopted");
+    ok = ok && result.worst < 1e-3 && fabs(result.skew_ppm - kSkewPpm) < 7 &&
+         result.rejects_delayed_replies && result.adopts_slower_link;
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSSERIAL_BENCHMARK_LOOPBACK_HARDWARE_H_
+#define ROSSERIAL_BENCHMARK_LOOPBACK_HARDWARE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include "ros/hardware.h"
+#include "ros/tx_queue.h"
+
+namespace benchmark {
+
+// Hardware whose output is its own input: bytes written go into an
+// in-memory ring and are read back from it, so the client core can be
+// timed without a link. It is bound to NodeHandle_ at compile time, like
+// StaticArduinoHardware. The clock only moves when it is told to.
+template<int Size>
+class LoopbackHardware : public ros::StaticHardware {
+ public:
+  LoopbackHardware() : ring_(buffer_, Size), time_(0), overflow_count_(0) {}
+
+  void setBaud(long baud) {}
+  int getBaud() const { return 0; }
+  void init() {}
+
+  int read() {
+    if (ring_.count() == 0) {
+      return -1;
+    }
+    int input_byte = ring_.peek(0);
+    ring_.pop(1);
+    return input_byte;
+  }
+
+  int read(uint8_t* buffer, int max) {
+    int count = 0;
+    while (count < max && ring_.count() > 0) {
+      int span;
+      const unsigned char* data = ring_.front(&span);
+      if (span > max - count) {
+        span = max - count;
+      }
+      memcpy(buffer + count, data, span);
+      ring_.pop(span);
+      count += span;
+    }
+    return count;
+  }
+
+  int available() { return ring_.count(); }
+
+  void write(uint8_t* data, int length) {
+    if (!ring_.push(data, length)) {
+      ++overflow_count_;
+    }
+  }
+
+  int availableForWrite() { return ring_.space(); }
+
+  unsigned long time() const { return time_; }
+  unsigned long timeMicros() const { return time_ * 1000ul; }
+  void setTime(unsigned long time) { time_ = time; }
+
+  // Drops everything written so far.
+  void clear() { ring_.pop(ring_.count()); }
+  // Number of writes that did not fit and were dropped.
+  int getOverflowCount() const { return overflow_count_; }
+
+ private:
+  unsigned char buffer_[Size];
+  ros::FrameRing ring_;
+  unsigned long time_;
+  int overflow_count_;
+
+  LoopbackHardware(const LoopbackHardware&);
+  void operator=(const LoopbackHardware&);
+};
+
+}  // namespace benchmark
+
+#endif  // ROSSERIAL_BENCHMARK_LOOPBACK_HARDWARE_H_
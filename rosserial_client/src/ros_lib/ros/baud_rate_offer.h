@@ -0,0 +1,99 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *  notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer in the documentation and/or other materials provided
+ *  with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *  contributors may be used to endorse or promote prducts derived
+ *  from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROS_BAUD_RATE_OFFER_H_
+#define ROS_BAUD_RATE_OFFER_H_
+
+#include <stdint.h>
+
+#include "msg.h"
+
+namespace ros {
+
+  /* The baud rates a device offers the host, each as 32 bits. Only those
+   * below limit are offered, unless limit is 0.
+   */
+  class BaudRateOffer : public Msg {
+    public:
+      BaudRateOffer(const long* rates, int count, long limit)
+          : rates_(rates), count_(count), limit_(limit) {}
+
+      virtual int serialize(unsigned char* buffer, int limit) {
+        int length = serializedLength();
+        if (length > limit) {
+          return -1;
+        }
+        int offset = 0;
+        for (int i = 0; i < count_; i++) {
+          if (offered(rates_[i])) {
+            uint32_t rate = rates_[i];
+            copyToWire(buffer + offset, &rate, 1);
+            offset += 4;
+          }
+        }
+        return offset;
+      }
+
+      // Offers are only built for sending.
+      virtual int deserialize(unsigned char*, int) {
+        return -1;
+      }
+
+      virtual int serializedLength() {
+        int length = 0;
+        for (int i = 0; i < count_; i++) {
+          if (offered(rates_[i])) {
+            length += 4;
+          }
+        }
+        return length;
+      }
+
+      virtual const char* getType() {
+        return "";
+      }
+
+    private:
+      const long* rates_;
+      int count_;
+      long limit_;
+
+      bool offered(long rate) const {
+        return limit_ == 0 || rate < limit_;
+      }
+  };
+
+}  // namespace ros
+
+#endif
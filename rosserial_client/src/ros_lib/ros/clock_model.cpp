@@ -0,0 +1,125 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ros/clock_model.h"
+
+namespace ros {
+
+namespace {
+
+// Share of each measured offset and skew error that is corrected. Lower
+// gains average out more of the serial link's jitter.
+const float kOffsetGain = 0.5f;
+const float kSkewGain = 0.25f;
+// Skew estimates are clamped to what a crystal or resonator can be off by.
+const float kMaxSkew = 0.005f;
+
+}  // namespace
+
+ClockModel::ClockModel() {
+  reset();
+}
+
+void ClockModel::reset() {
+  anchor_local_ = 0;
+  anchor_host_ = Time();
+  skew_ = 0;
+  round_trip_ = 0;
+  sample_count_ = 0;
+  rejected_count_ = 0;
+  consecutive_rejects_ = 0;
+}
+
+bool ClockModel::update(unsigned long sent_us, const Time& host_time,
+                        unsigned long received_us) {
+  unsigned long round_trip = received_us - sent_us;
+  if (sample_count_ > 0 && round_trip > kOutlierFactor * round_trip_) {
+    ++rejected_count_;
+    if (++consecutive_rejects_ < kMaxConsecutiveRejects) {
+      return false;
+    }
+    round_trip_ = round_trip;
+  }
+  consecutive_rejects_ = 0;
+  if (sample_count_ == 0) {
+    round_trip_ = round_trip;
+  } else {
+    // Track the round trip time, following decreases faster than increases.
+    if (round_trip < round_trip_) {
+      round_trip_ = (round_trip_ + round_trip) / 2;
+    } else {
+      round_trip_ += (round_trip - round_trip_) / 8;
+    }
+  }
+
+  // Assume the host stamped its reply halfway through the round trip.
+  unsigned long midpoint = sent_us + round_trip / 2;
+  if (sample_count_ == 0) {
+    anchor_local_ = midpoint;
+    anchor_host_ = host_time;
+    ++sample_count_;
+    return true;
+  }
+  unsigned long elapsed = midpoint - anchor_local_;
+  Time predicted = anchor_host_ + extrapolate(elapsed);
+  float error = (host_time - predicted).toSec();
+  if (elapsed > 0) {
+    // Take the first skew estimate in full; filter later ones.
+    float gain = sample_count_ == 1 ? 1.0f : kSkewGain;
+    skew_ += gain * error / (elapsed * 1e-6f);
+    if (skew_ > kMaxSkew) {
+      skew_ = kMaxSkew;
+    } else if (skew_ < -kMaxSkew) {
+      skew_ = -kMaxSkew;
+    }
+  }
+  anchor_local_ = midpoint;
+  anchor_host_ = predicted + Duration::fromSec(
+      (sample_count_ == 1 ? 1.0f : kOffsetGain) * error);
+  ++sample_count_;
+  return true;
+}
+
+Time ClockModel::toHostTime(unsigned long local_us) const {
+  return anchor_host_ + extrapolate(local_us - anchor_local_);
+}
+
+Duration ClockModel::extrapolate(unsigned long local_delta) const {
+  long correction = skew_ * local_delta;
+  // 2^13 seconds covers every 32 bit count of microseconds.
+  long sec = splitUnits(&local_delta, 1000000ul, 13);
+  return Duration(sec, local_delta * 1000l) + Duration::fromMicros(correction);
+}
+
+}  // namespace ros
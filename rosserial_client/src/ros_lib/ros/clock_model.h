@@ -0,0 +1,96 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROS_CLOCK_MODEL_H_
+#define ROS_CLOCK_MODEL_H_
+
+#include "ros/duration.h"
+#include "ros/time.h"
+
+namespace ros {
+
+// Maps the local microsecond clock to host time. Each time sync round trip
+// corrects both the offset and the skew (rate error) of the local clock,
+// so host time can be extrapolated accurately between infrequent syncs.
+// Round trips much slower than usual are rejected, since their midpoint
+// says little about when the host stamped its reply.
+class ClockModel {
+ public:
+  ClockModel();
+
+  // Adds a round trip: the request left at local time sent_us, the host
+  // stamped its reply with host_time, and the reply arrived at local time
+  // received_us. Returns false if the round trip was rejected.
+  bool update(unsigned long sent_us, const Time& host_time,
+              unsigned long received_us);
+
+  // Host time at local time local_us. Before the first update this is the
+  // local time itself.
+  Time toHostTime(unsigned long local_us) const;
+
+  // Forgets all round trips, e.g. after the connection was lost.
+  void reset();
+
+  bool isSynced() const { return sample_count_ > 0; }
+  // Estimated rate error of the local clock; 20e-6 means it runs 20 ppm
+  // slow.
+  float getSkew() const { return skew_; }
+  // Filtered round trip time in microseconds.
+  unsigned long getRoundTripTime() const { return round_trip_; }
+  int getRejectedCount() const { return rejected_count_; }
+
+ private:
+  // Round trips longer than this many times the filtered round trip time
+  // are rejected...
+  static const int kOutlierFactor = 2;
+  // ...unless this many in a row were, in which case the link has become
+  // slower and the filter starts over from the new round trip time.
+  static const int kMaxConsecutiveRejects = 3;
+
+  // Local time of the last accepted sample and the host time it maps to.
+  unsigned long anchor_local_;
+  Time anchor_host_;
+  float skew_;
+  unsigned long round_trip_;
+  int sample_count_;
+  int rejected_count_;
+  int consecutive_rejects_;
+
+  // Host time elapsed over local_delta microseconds of local time.
+  Duration extrapolate(unsigned long local_delta) const;
+};
+
+}  // namespace ros
+
+#endif  // ROS_CLOCK_MODEL_H_
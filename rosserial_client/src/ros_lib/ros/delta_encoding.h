@@ -0,0 +1,190 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *  notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer in the documentation and/or other materials provided
+ *  with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *  contributors may be used to endorse or promote prducts derived
+ *  from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROS_DELTA_ENCODING_H_
+#define ROS_DELTA_ENCODING_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include "msg.h"
+#include "rosserial_msgs/TopicInfo.h"
+
+namespace ros {
+
+  /* Samples of a topic listed with ENCODING_DELTA start with their kind
+   * and an 8 bit sequence number. A keyframe carries the serialized
+   * message,
+   *   [0][sequence][message]
+   * and a delta the XOR of the message with the one sent before it, of
+   * the same length, as runs of up to 255 unchanged bytes, which are
+   * skipped, each followed by a run of up to 255 changed ones.
+   *   [1][sequence][unchanged][changed][changed bytes][unchanged]...
+   * Unchanged bytes at the end are left out. A host that missed the
+   * previous sequence number drops deltas until the next keyframe.
+   */
+  class DeltaFrame : public Msg {
+    public:
+      static const unsigned char kKeyframe = 0;
+      static const unsigned char kDelta = 1;
+      static const int kHeaderSize = 2;
+
+      // sample is the serialized message. A keyframe is sent if previous
+      // is 0, else the delta to it.
+      DeltaFrame(unsigned char sequence, const unsigned char* sample,
+                 const unsigned char* previous, int length)
+          : sequence_(sequence), sample_(sample), previous_(previous),
+            length_(length),
+            encoded_length_(previous == 0 ? length : encode(0)) {}
+
+      virtual int serialize(unsigned char* buffer, int limit) {
+        if (kHeaderSize + encoded_length_ > limit) {
+          return -1;
+        }
+        buffer[0] = previous_ == 0 ? kKeyframe : kDelta;
+        buffer[1] = sequence_;
+        if (previous_ == 0) {
+          memcpy(buffer + kHeaderSize, sample_, length_);
+        } else {
+          encode(buffer + kHeaderSize);
+        }
+        return kHeaderSize + encoded_length_;
+      }
+
+      // Frames are only built for sending.
+      virtual int deserialize(unsigned char*, int) {
+        return -1;
+      }
+
+      virtual int serializedLength() {
+        return kHeaderSize + encoded_length_;
+      }
+
+      virtual const char* getType() {
+        return "";
+      }
+
+    private:
+      unsigned char sequence_;
+      const unsigned char* sample_;
+      const unsigned char* previous_;
+      int length_;
+      int encoded_length_;
+
+      // Writes the delta to buffer, or only measures it if buffer is 0.
+      // Returns its length.
+      int encode(unsigned char* buffer) const {
+        int offset = 0;
+        int i = 0;
+        while (true) {
+          int start = i;
+          while (start < length_ && sample_[start] == previous_[start]) {
+            start++;
+          }
+          if (start == length_) {
+            return offset;
+          }
+          // Longer unchanged runs take pairs without changed bytes.
+          while (start - i > 255) {
+            if (buffer != 0) {
+              buffer[offset] = 255;
+              buffer[offset + 1] = 0;
+            }
+            offset += 2;
+            i += 255;
+          }
+          int unchanged = start - i;
+          i = start;
+          // A single unchanged byte between changed ones is cheaper to
+          // send than a new pair of runs.
+          while (i < length_ && i - start < 255 &&
+                 (sample_[i] != previous_[i] ||
+                  (i + 1 < length_ && sample_[i + 1] != previous_[i + 1]))) {
+            i++;
+          }
+          if (buffer != 0) {
+            buffer[offset] = unchanged;
+            buffer[offset + 1] = i - start;
+            for (int j = start; j < i; j++) {
+              buffer[offset + 2 + j - start] = sample_[j] ^ previous_[j];
+            }
+          }
+          offset += 2 + i - start;
+        }
+      }
+  };
+
+  /* The listing of a publisher: its TopicInfo, followed by its encoding
+   * as one byte unless that is ENCODING_NONE, so that plain listings keep
+   * the layout hosts without encodings expect.
+   */
+  class TopicListing : public Msg {
+    public:
+      TopicListing(rosserial_msgs::TopicInfo* topic_info, uint8_t encoding)
+          : topic_info_(topic_info), encoding_(encoding) {}
+
+      virtual int serialize(unsigned char* buffer, int limit) {
+        int length = topic_info_->serialize(buffer, limit);
+        if (length < 0 || encoding_ == rosserial_msgs::TopicInfo::ENCODING_NONE) {
+          return length;
+        }
+        if (length + 1 > limit) {
+          return -1;
+        }
+        buffer[length] = encoding_;
+        return length + 1;
+      }
+
+      // Listings are only built for sending.
+      virtual int deserialize(unsigned char*, int) {
+        return -1;
+      }
+
+      virtual int serializedLength() {
+        return topic_info_->serializedLength() +
+               (encoding_ == rosserial_msgs::TopicInfo::ENCODING_NONE ? 0 : 1);
+      }
+
+      virtual const char* getType() {
+        return topic_info_->getType();
+      }
+
+    private:
+      rosserial_msgs::TopicInfo* topic_info_;
+      uint8_t encoding_;
+  };
+
+}  // namespace ros
+
+#endif
@@ -34,10 +34,35 @@
 
 #include "ros/duration.h"
 
-#include <math.h>
-
 namespace ros {
 
+unsigned long splitUnits(unsigned long* value, unsigned long unit, int bits) {
+#if defined(__AVR__)
+  if (*value < unit) {
+    return 0;
+  }
+  if (*value >> bits < unit) {
+    // Long division by unit, one quotient bit at a time.
+    unsigned long scaled = unit << (bits - 1);
+    unsigned long quotient = 0;
+    for (unsigned long bit = 1ul << (bits - 1); bit != 0; bit >>= 1) {
+      if (*value >= scaled) {
+        *value -= scaled;
+        quotient |= bit;
+      }
+      scaled >>= 1;
+    }
+    return quotient;
+  }
+#else
+  (void) bits;
+#endif
+  // Elsewhere the compiler turns this into a multiply.
+  unsigned long quotient = *value / unit;
+  *value -= quotient * unit;
+  return quotient;
+}
+
 Duration::Duration() : sec(0), nsec(0) {}
 
 Duration::Duration(long sec, long nsec) : sec(sec), nsec(nsec) {
@@ -49,13 +74,29 @@ float Duration::toSec() const {
 }
 
 Duration Duration::fromSec(float seconds) {
-  long sec = floor(seconds);
-  long nsec = round((seconds - sec) * 1e9f);
+  // Casts truncate towards zero; floor() and round() are library calls.
+  long sec = static_cast<long>(seconds);
+  if (seconds < sec) {
+    --sec;
+  }
+  long nsec = static_cast<long>((seconds - sec) * 1e9f + 0.5f);
   return Duration(sec, nsec);
 }
 
 Duration Duration::fromMillis(long millis) {
-  return Duration(millis / 1000, (millis % 1000) * 1000000l);
+  unsigned long magnitude = millis < 0 ? -static_cast<unsigned long>(millis) : millis;
+  // 2^22 seconds covers every long count of milliseconds, 2^12 every
+  // long count of microseconds.
+  long sec = splitUnits(&magnitude, 1000ul, 22);
+  long nsec = magnitude * 1000000l;
+  return millis < 0 ? Duration(-sec, -nsec) : Duration(sec, nsec);
+}
+
+Duration Duration::fromMicros(long micros) {
+  unsigned long magnitude = micros < 0 ? -static_cast<unsigned long>(micros) : micros;
+  long sec = splitUnits(&magnitude, 1000000ul, 12);
+  long nsec = magnitude * 1000l;
+  return micros < 0 ? Duration(-sec, -nsec) : Duration(sec, nsec);
 }
 
 Duration& Duration::operator+=(const Duration &rhs) {
@@ -88,13 +129,24 @@ Duration Duration::operator-(const Duration &rhs) const {
 }
 
 void Duration::normalize() {
-  while (nsec > 1000000000l) {
+  // Sums and differences of normalized durations are less than a second
+  // out, so one conditional step is enough. Only out of range constructor
+  // arguments and scaling take the divide.
+  if (nsec >= 1000000000l) {
     nsec -= 1000000000l;
     ++sec;
-  }
-  while (nsec < 0) {
+    if (nsec >= 1000000000l) {
+      sec += nsec / 1000000000l;
+      nsec %= 1000000000l;
+    }
+  } else if (nsec < 0) {
     nsec += 1000000000l;
     --sec;
+    if (nsec < 0) {
+      long borrow = (999999999l - nsec) / 1000000000l;
+      sec -= borrow;
+      nsec += borrow * 1000000000l;
+    }
   }
 }
 
@@ -48,6 +48,7 @@ class Duration {
   float toSec() const;
   static Duration fromSec(float seconds);
   static Duration fromMillis(long millis);
+  static Duration fromMicros(long micros);
 
   Duration& operator+=(const Duration &rhs);
   Duration& operator-=(const Duration &rhs);
@@ -59,6 +60,12 @@ class Duration {
   void normalize();
 };
 
+// Returns *value / unit and leaves the remainder in *value. AVR has no
+// divide instruction and libgcc's 32 bit divide loop would dominate time
+// arithmetic, so there it uses one shift and subtract step for each of
+// bits quotient bits, for a constant unit. Larger quotients are divided.
+unsigned long splitUnits(unsigned long* value, unsigned long unit, int bits);
+
 }  // namespace ros
 
 #endif
@@ -39,17 +39,51 @@
 
 namespace ros {
 
+// Interface for the link to the host. NodeHandle (NodeHandle_<Hardware>)
+// calls it through virtual functions, so one binary can drive any backend
+// chosen at run time.
 class Hardware {
  public:
   virtual ~Hardware() {}
   virtual void setBaud(long baud) = 0;
   virtual int getBaud() const = 0;
   virtual void init() = 0;
+  // Returns the next input byte, or -1 if none is available.
   virtual int read() = 0;
+  // Copies up to max available input bytes into buffer without blocking.
+  // Returns the number of bytes copied. Backends that can move data in
+  // bulk should override this; the default falls back to read().
+  virtual int read(uint8_t* buffer, int max) {
+    int count = 0;
+    while (count < max) {
+      int input_byte = read();
+      if (input_byte < 0) {
+        break;
+      }
+      buffer[count++] = input_byte;
+    }
+    return count;
+  }
+  // Returns the number of input bytes that can be read without blocking,
+  // or 0 if the backend cannot tell.
+  virtual int available() { return 0; }
   virtual void write(uint8_t* data, int length) = 0;
+  // Returns the number of bytes write() can take without blocking, or -1
+  // if the backend cannot tell.
+  virtual int availableForWrite() { return -1; }
+  // Milliseconds since start-up.
   virtual unsigned long time() const = 0;
+  // Microseconds since start-up, wrapping around like micros(). Used for
+  // time synchronization; backends with a finer clock should override it.
+  virtual unsigned long timeMicros() const { return time() * 1000ul; }
 };
 
+// Empty base for hardware classes bound to NodeHandle_ at compile time.
+// Such a class provides the same member functions as Hardware, but not
+// virtually: NodeHandle_<MyHardware> calls them directly, the compiler can
+// inline them into spinOnce(), and no vtable is emitted.
+class StaticHardware {};
+
 }  // namespace ros
 
 #endif  // ROS_HARDWARE_H_
@@ -0,0 +1,96 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROS_LINK_STATISTICS_H_
+#define ROS_LINK_STATISTICS_H_
+
+#include <stdint.h>
+
+// Define ROSSERIAL_DIAGNOSTICS to 1 to count traffic per topic, time
+// spinOnce() and subscriber callbacks, and send the numbers to the host as
+// rosserial_msgs/LinkStatistics. Left at 0, none of it is compiled in.
+#ifndef ROSSERIAL_DIAGNOSTICS
+#define ROSSERIAL_DIAGNOSTICS 0
+#endif
+
+namespace ros {
+
+// Frames and bytes of one topic, as in rosserial_msgs/TopicStatistics.
+struct TopicCounters {
+  uint32_t frames;
+  uint32_t bytes;
+  uint32_t dropped;
+
+  TopicCounters() : frames(0), bytes(0), dropped(0) {}
+
+  // Counts the result of sending or receiving a frame: its length, or a
+  // negative value if it was dropped.
+  void count(int length) {
+    if (length < 0) {
+      ++dropped;
+    } else {
+      ++frames;
+      bytes += length;
+    }
+  }
+};
+
+// Durations in power-of-two buckets of microseconds, as in
+// rosserial_msgs/LinkStatistics: bucket 0 counts durations below 16 us,
+// bucket i those from 2^(i+3) to 2^(i+4) - 1 us.
+class DurationHistogram {
+ public:
+  static const int kBuckets = 12;
+
+  DurationHistogram() : counts_() {}
+
+  void add(unsigned long duration_us) {
+    int bucket = 0;
+    duration_us >>= 4;
+    while (duration_us != 0 && bucket < kBuckets - 1) {
+      duration_us >>= 1;
+      ++bucket;
+    }
+    ++counts_[bucket];
+  }
+
+  const uint32_t* getCounts() const { return counts_; }
+
+ private:
+  uint32_t counts_[kBuckets];
+};
+
+}  // namespace ros
+
+#endif  // ROS_LINK_STATISTICS_H_
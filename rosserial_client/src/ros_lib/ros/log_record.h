@@ -0,0 +1,202 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *  notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer in the documentation and/or other materials provided
+ *  with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *  contributors may be used to endorse or promote prducts derived
+ *  from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROS_LOG_RECORD_H_
+#define ROS_LOG_RECORD_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+#endif
+
+#include "msg.h"
+
+// Log calls below this level are compiled out: 0 keeps everything, 1
+// drops debug messages, up to 4 for fatal errors only.
+#ifndef ROSSERIAL_LOG_LEVEL
+#define ROSSERIAL_LOG_LEVEL 0
+#endif
+
+// Keeps a log format string in flash on AVR, e.g.
+//   const char kSpeedFormat[] ROSSERIAL_PROGMEM = "speed %d mm/s";
+#if defined(__AVR__)
+#define ROSSERIAL_PROGMEM PROGMEM
+#else
+#define ROSSERIAL_PROGMEM
+#endif
+
+namespace ros {
+
+  inline char readProgmem(const char* address) {
+#if defined(__AVR__)
+    return pgm_read_byte(address);
+#else
+    return *address;
+#endif
+  }
+
+  /* Registers a format string with the host during topic negotiation,
+   *   [format_id][format]
+   * where the format, read from ROSSERIAL_PROGMEM, runs to the end of
+   * the frame.
+   */
+  class LogFormat : public Msg {
+    public:
+      LogFormat(uint16_t format_id, const char* format)
+          : format_id_(format_id), format_(format) {}
+
+      virtual int serialize(unsigned char* buffer, int limit) {
+        int length = serializedLength();
+        if (length > limit) {
+          return -1;
+        }
+        buffer[0] = format_id_ & 0xff;
+        buffer[1] = format_id_ >> 8;
+        for (int i = 2; i < length; i++) {
+          buffer[i] = readProgmem(format_ + i - 2);
+        }
+        return length;
+      }
+
+      virtual int deserialize(unsigned char*, int) {
+        return -1;
+      }
+
+      virtual int serializedLength() {
+        int length = 2;
+        while (readProgmem(format_ + length - 2) != 0) {
+          length++;
+        }
+        return length;
+      }
+
+      virtual const char* getType() {
+        return "";
+      }
+
+    private:
+      uint16_t format_id_;
+      const char* format_;
+  };
+
+  /* A log message sent as the ID of its format and the raw arguments,
+   *   [level][format_id][arguments]
+   * for the host to format. Integers take 4 bytes, floats are sent as 4
+   * byte IEEE 754 and strings with their terminator. The host reads the
+   * arguments by the conversions of the format, so they have to match:
+   * an integer for %d, %i, %u, %o, %x or %c, a float for %e, %f or %g
+   * and a string for %s.
+   */
+  class LogRecord : public Msg {
+    public:
+      // Bytes of arguments a record holds. Strings are cut short to fit.
+      static const int kMaxArgumentSize = 32;
+
+      LogRecord(uint8_t level, uint16_t format_id) : length_(3) {
+        data_[0] = level;
+        data_[1] = format_id & 0xff;
+        data_[2] = format_id >> 8;
+      }
+
+      void append(char value) { appendInteger(value); }
+      void append(signed char value) { appendInteger(value); }
+      void append(unsigned char value) { appendInteger(value); }
+      void append(short value) { appendInteger(value); }
+      void append(unsigned short value) { appendInteger(value); }
+      void append(int value) { appendInteger(value); }
+      void append(unsigned int value) { appendInteger(value); }
+      void append(long value) { appendInteger(value); }
+      void append(unsigned long value) { appendInteger(value); }
+
+      void append(float value) {
+        if (length_ + 4 <= kSize) {
+          copyToWire(data_ + length_, &value, 1);
+          length_ += 4;
+        }
+      }
+
+      void append(double value) {
+        append(static_cast<float>(value));
+      }
+
+      void append(const char* value) {
+        while (length_ < kSize - 1 && *value != 0) {
+          data_[length_++] = *value++;
+        }
+        if (length_ < kSize) {
+          data_[length_++] = 0;
+        }
+      }
+
+      virtual int serialize(unsigned char* buffer, int limit) {
+        if (length_ > limit) {
+          return -1;
+        }
+        memcpy(buffer, data_, length_);
+        return length_;
+      }
+
+      virtual int deserialize(unsigned char*, int) {
+        return -1;
+      }
+
+      virtual int serializedLength() {
+        return length_;
+      }
+
+      virtual const char* getType() {
+        return "";
+      }
+
+    private:
+      static const int kSize = 3 + kMaxArgumentSize;
+
+      unsigned char data_[kSize];
+      int length_;
+
+      // Negative values wrap modulo 2^32, which the host reads back as
+      // signed for %d and %i.
+      void appendInteger(uint32_t value) {
+        if (length_ + 4 <= kSize) {
+          copyToWire(data_ + length_, &value, 1);
+          length_ += 4;
+        }
+      }
+  };
+
+}  // namespace ros
+
+#endif
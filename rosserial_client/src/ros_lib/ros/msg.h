@@ -35,13 +35,66 @@
 #ifndef ROS_MSG_H_
 #define ROS_MSG_H_
 
+#include <string.h>
+
+// 1 if the target stores primitives in wire (little-endian) byte order.
+#ifndef ROSSERIAL_LITTLE_ENDIAN
+#if defined(__AVR__) || defined(__ARMEL__) || defined(__i386__) || \
+    defined(__x86_64__) || (defined(__BYTE_ORDER__) && \
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define ROSSERIAL_LITTLE_ENDIAN 1
+#else
+#define ROSSERIAL_LITTLE_ENDIAN 0
+#endif
+#endif
+
 namespace ros {
 
+  // Copy count primitives to and from the little-endian wire format. On
+  // little-endian targets each is a single memcpy. Used by generated
+  // messages.
+  template<typename T>
+  inline void copyToWire(unsigned char* buffer, const T* values, int count) {
+#if ROSSERIAL_LITTLE_ENDIAN
+    memcpy(buffer, values, count * sizeof(T));
+#else
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(values);
+    for (int i = 0; i < count; i++) {
+      for (unsigned int k = 0; k < sizeof(T); k++) {
+        buffer[i * sizeof(T) + k] = bytes[i * sizeof(T) + sizeof(T) - 1 - k];
+      }
+    }
+#endif
+  }
+
+  template<typename T>
+  inline void copyFromWire(T* values, const unsigned char* buffer, int count) {
+#if ROSSERIAL_LITTLE_ENDIAN
+    memcpy(values, buffer, count * sizeof(T));
+#else
+    unsigned char* bytes = reinterpret_cast<unsigned char*>(values);
+    for (int i = 0; i < count; i++) {
+      for (unsigned int k = 0; k < sizeof(T); k++) {
+        bytes[i * sizeof(T) + k] = buffer[i * sizeof(T) + sizeof(T) - 1 - k];
+      }
+    }
+#endif
+  }
+
+  // Compile-time assertion for C++98: StaticCheck<false> is incomplete, so
+  // sizeof(StaticCheck<condition>) fails to compile when condition is false.
+  template<bool> struct StaticCheck;
+  template<> struct StaticCheck<true> {};
+
   // Message base class
+  // Generated messages also define enum kMaxSerializedSize, the largest
+  // serialized size, or -1 if they hold strings or unbounded arrays.
   class Msg {
     public:
       virtual int serialize(unsigned char* buffer, int limit) = 0;
       virtual int deserialize(unsigned char* buffer, int limit) = 0;
+      // Bytes serialize() will write for the current contents.
+      virtual int serializedLength() = 0;
       virtual const char* getType() = 0;
   };
 
@@ -35,25 +35,45 @@
 #ifndef ROS_MSG_RECEIVER_H_
 #define ROS_MSG_RECEIVER_H_
 
+#include "link_statistics.h"
+#include "rosserial_ids.h"
+
 namespace ros {
 
   // Base class for objects recieving messages (Services and Subscribers).
   class MsgReceiver {
     public:
-      MsgReceiver() : id_(0), topic_name_(0) {}
+      MsgReceiver() : id_(0), topic_name_(0), priority_(0) {}
       virtual ~MsgReceiver() {}
 
       virtual bool receive(unsigned char* data, int limit) = 0;
       virtual const char* getMessageType() = 0;
+      // What the node handle lists the receiver as: TOPIC_SUBSCRIBERS,
+      // TOPIC_SERVICES or TOPIC_SERVICE_CLIENTS.
+      virtual int getTopicType() { return TOPIC_SUBSCRIBERS; }
 
       void setId(int id) { id_ = id; }
       int getId() { return id_; }
 
       const char* getTopicName() { return topic_name_; }
 
+      // Order in which NodeHandle::spinFor() runs deferred callbacks,
+      // highest first. 0 by default.
+      void setPriority(unsigned char priority) { priority_ = priority; }
+      unsigned char getPriority() { return priority_; }
+
+#if ROSSERIAL_DIAGNOSTICS
+      // Counted by the node handle for each frame it hands to receive().
+      TopicCounters& getCounters() { return counters_; }
+#endif
+
     protected:
       int id_;
       const char* topic_name_;
+      unsigned char priority_;
+#if ROSSERIAL_DIAGNOSTICS
+      TopicCounters counters_;
+#endif
 
     private:
       MsgReceiver(const MsgReceiver&);
@@ -0,0 +1,229 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROS_MSG_VIEW_H_
+#define ROS_MSG_VIEW_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include "ros/msg.h"
+#include "ros/time.h"
+
+namespace ros {
+
+  // Decoders for fixed-size fields, used by the generated message views
+  // (e.g. sensor_msgs::LaserScanView). Views read fields straight out of
+  // a received frame instead of deserializing it into a message.
+  template<typename T>
+  struct Wire {
+    typedef T Type;
+    enum { kSize = sizeof(T) };
+
+    static T read(const unsigned char* buffer) {
+      T value;
+      copyFromWire(&value, buffer, 1);
+      return value;
+    }
+  };
+
+  // float64 is narrowed to float, as in the generated messages.
+  struct Float64Wire {
+    typedef float Type;
+    enum { kSize = 8 };
+
+    static float read(const unsigned char* buffer) {
+      uint32_t bits = (static_cast<uint32_t>(buffer[3]) >> 5) & 0x07;
+      bits |= static_cast<uint32_t>(buffer[4]) << 3;
+      bits |= static_cast<uint32_t>(buffer[5]) << 11;
+      bits |= (static_cast<uint32_t>(buffer[6]) & 0x0f) << 19;
+      uint32_t exponent = (static_cast<uint32_t>(buffer[6]) & 0xf0) >> 4;
+      exponent |= (static_cast<uint32_t>(buffer[7]) & 0x7f) << 4;
+      if (exponent != 0) {
+        bits |= (exponent - 1023 + 127) << 23;
+      }
+      if ((buffer[7] & 0x80) > 0) {
+        bits |= 1ul << 31;
+      }
+      float value;
+      memcpy(&value, &bits, sizeof(value));
+      return value;
+    }
+  };
+
+  // int64 and uint64 keep their low 32 bits, as in the generated messages.
+  struct Int64Wire {
+    typedef int32_t Type;
+    enum { kSize = 8 };
+
+    static int32_t read(const unsigned char* buffer) {
+      return Wire<int32_t>::read(buffer);
+    }
+  };
+
+  struct TimeWire {
+    typedef Time Type;
+    enum { kSize = 8 };
+
+    static Time read(const unsigned char* buffer) {
+      return Time(Wire<uint32_t>::read(buffer), Wire<uint32_t>::read(buffer + 4));
+    }
+  };
+
+  struct DurationWire {
+    typedef Duration Type;
+    enum { kSize = 8 };
+
+    static Duration read(const unsigned char* buffer) {
+      return Duration(Wire<int32_t>::read(buffer), Wire<int32_t>::read(buffer + 4));
+    }
+  };
+
+  // A string field. The characters stay in the frame and are not
+  // NUL-terminated.
+  class StringView {
+    public:
+      StringView(const unsigned char* buffer, int limit)
+          : buffer_(buffer), limit_(limit) {}
+
+      const char* data() const {
+        return reinterpret_cast<const char*>(buffer_ + 4);
+      }
+
+      uint32_t length() const {
+        return Wire<uint32_t>::read(buffer_);
+      }
+
+      bool equals(const char* str) const {
+        return strlen(str) == length() && memcmp(data(), str, length()) == 0;
+      }
+
+      // Copies at most size - 1 characters and a NUL into str. Returns the
+      // number of characters copied.
+      int copyTo(char* str, int size) const {
+        if (size <= 0) {
+          return 0;
+        }
+        int count = length() < uint32_t(size - 1) ? length() : size - 1;
+        memcpy(str, data(), count);
+        str[count] = '\0';
+        return count;
+      }
+
+      // Bytes the field occupies in the frame, or -1 if it overruns limit.
+      int wireSize() const {
+        if (limit_ < 4 || length() > uint32_t(limit_ - 4)) {
+          return -1;
+        }
+        return 4 + length();
+      }
+
+    private:
+      const unsigned char* buffer_;
+      int limit_;
+  };
+
+  // An array of fixed-size elements, decoded by WireT on access.
+  template<class WireT>
+  class ArrayView {
+    public:
+      typedef typename WireT::Type Type;
+
+      ArrayView(const unsigned char* data, uint32_t length)
+          : data_(data), length_(length) {}
+
+      uint32_t length() const {
+        return length_;
+      }
+
+      Type operator[](uint32_t i) const {
+        return WireT::read(data_ + i * WireT::kSize);
+      }
+
+      // Copies at most max elements into values. Returns the number copied.
+      uint32_t copyTo(Type* values, uint32_t max) const {
+        uint32_t count = length_ < max ? length_ : max;
+        for (uint32_t i = 0; i < count; i++) {
+          values[i] = (*this)[i];
+        }
+        return count;
+      }
+
+    private:
+      const unsigned char* data_;
+      uint32_t length_;
+  };
+
+  // An array of strings or messages. Elements vary in size, so
+  // operator[] walks the array from the front.
+  template<class ViewT>
+  class SequenceView {
+    public:
+      SequenceView(const unsigned char* data, uint32_t length, int limit)
+          : data_(data), length_(length), limit_(limit) {}
+
+      uint32_t length() const {
+        return length_;
+      }
+
+      ViewT operator[](uint32_t i) const {
+        int offset = 0;
+        for (uint32_t k = 0; k < i; k++) {
+          offset += ViewT(data_ + offset, limit_ - offset).wireSize();
+        }
+        return ViewT(data_ + offset, limit_ - offset);
+      }
+
+      // Bytes the elements occupy in the frame, or -1 if they overrun limit.
+      int wireSize() const {
+        int offset = 0;
+        for (uint32_t k = 0; k < length_; k++) {
+          int size = ViewT(data_ + offset, limit_ - offset).wireSize();
+          if (size < 0) {
+            return -1;
+          }
+          offset += size;
+        }
+        return offset;
+      }
+
+    private:
+      const unsigned char* data_;
+      uint32_t length_;
+      int limit_;
+  };
+
+}  // namespace ros
+
+#endif  // ROS_MSG_VIEW_H_
@@ -8,13 +8,13 @@
  * modification, are permitted provided that the following conditions
  * are met:
  *
- * * Redistributions of source code must retain the above copyright
+ *  * Redistributions of source code must retain the above copyright
  *    notice, this list of conditions and the following disclaimer.
- * * Redistributions in binary form must reproduce the above
+ *  * Redistributions in binary form must reproduce the above
  *    copyright notice, this list of conditions and the following
  *    disclaimer in the documentation and/or other materials provided
  *    with the distribution.
- * * Neither the name of Willow Garage, Inc. nor the names of its
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
  *    contributors may be used to endorse or promote prducts derived
  *    from this software without specific prior written permission.
  *
@@ -35,18 +35,36 @@
 #ifndef ROS_NODE_HANDLE_H_
 #define ROS_NODE_HANDLE_H_
 
-#include "time.h"
-#include "subscriber.h"
+#include <string.h>
+
+#include "baud_rate_offer.h"
+#include "clock_model.h"
+#include "hardware.h"
+#include "link_statistics.h"
+#include "log_record.h"
+#include "msg_receiver.h"
+#include "node_output.h"
+#include "param_cache.h"
+#include "publisher.h"
+#include "rosserial_ids.h"
+#include "rx_queue.h"
+#include "service_client.h"
 #include "service_server.h"
+#include "subscriber.h"
+#include "time.h"
 
+#include "std_msgs/Time.h"
+#include "std_msgs/UInt32.h"
+#include "rosserial_msgs/TopicInfo.h"
+#include "rosserial_msgs/Log.h"
 #include "rosserial_msgs/RequestParam.h"
+#include "rosserial_msgs/RequestParams.h"
+#if ROSSERIAL_DIAGNOSTICS
+#include "rosserial_msgs/LinkStatistics.h"
+#endif
 
 namespace ros {
 
-class Hardware;
-class Publisher;
-class Time;
-
 enum PacketState {
   STATE_FIRST_FF,
   STATE_SECOND_FF,
@@ -58,26 +76,247 @@ enum PacketState {
   STATE_CHECKSUM,
 };
 
-class NodeHandle {
+// Format of the debug message logged after every time sync.
+const char kTimeSyncLogFormat[] ROSSERIAL_PROGMEM = "Time: %lu %lu";
+
+// Node handle with compile-time sized subscriber and publisher tables and
+// input and output buffers. A firmware only pays for the RAM it asks for,
+// e.g. NodeHandle_<ArduinoHardware, 2, 2, 128, 128>.
+template<class HardwareT,
+         int MaxSubscribers = 25,
+         int MaxPublishers = 25,
+         int InputSize = 512,
+         int OutputSize = 512>
+class NodeHandle_ {
  public:
-  NodeHandle(Hardware* hardware);
-  Hardware* getHardware();
+  NodeHandle_(HardwareT* hardware)
+      : hardware_(hardware),
+        node_output_(hardware),
+        connected_(false),
+        param_received_(false),
+        param_cache_(0),
+        param_batch_pending_(false),
+        param_batch_time_(0),
+        log_formats_(0),
+        log_format_count_(0),
+        baud_rates_(0),
+        baud_rate_count_(0),
+        baud_index_(0),
+        baud_error_threshold_(kDefaultBaudErrorThreshold),
+        baud_switch_pending_(false),
+        baud_switch_time_(0),
+        link_errors_at_sync_(0),
+        sync_period_(kDefaultSyncPeriod),
+        time_sync_pending_(false),
+        time_sync_start_(0),
+        time_sync_end_(0),
+        publishers(),
+        receivers(),
+        state_(STATE_FIRST_FF),
+        frame_length_(0),
+        replay_index_(0),
+        replay_end_(0),
+        resync_(true),
+        header_check_(false),
+        remaining_data_bytes_(0),
+        topic_(0),
+        data_index_(0),
+        checksum_(0),
+        invalid_size_error_count_(0),
+        checksum_error_count_(0),
+        state_error_count_(0),
+        malformed_message_error_count_(0),
+        total_receivers_(0),
+        coalescing_(0),
+        next_coalescing_(0),
+        rx_queue_(0),
+        dispatching_queued_(false)
+#if ROSSERIAL_DIAGNOSTICS
+        , diagnostics_time_(0),
+        next_diagnostics_topic_(0)
+#endif
+        {}
 
-  void logdebug(const char* msg);
-  void loginfo(const char* msg);
-  void logwarn(const char* msg);
-  void logerror(const char* msg);
-  void logfatal(const char* msg);
+  HardwareT* getHardware() {
+    return hardware_;
+  }
+
+  void logdebug(const char* msg) {
+    if (rosserial_msgs::Log::DEBUG >= ROSSERIAL_LOG_LEVEL) {
+      log(rosserial_msgs::Log::DEBUG, msg);
+    }
+  }
+
+  void loginfo(const char* msg) {
+    if (rosserial_msgs::Log::INFO >= ROSSERIAL_LOG_LEVEL) {
+      log(rosserial_msgs::Log::INFO, msg);
+    }
+  }
+
+  void logwarn(const char* msg) {
+    if (rosserial_msgs::Log::WARN >= ROSSERIAL_LOG_LEVEL) {
+      log(rosserial_msgs::Log::WARN, msg);
+    }
+  }
+
+  void logerror(const char* msg) {
+    if (rosserial_msgs::Log::ERROR >= ROSSERIAL_LOG_LEVEL) {
+      log(rosserial_msgs::Log::ERROR, msg);
+    }
+  }
+
+  void logfatal(const char* msg) {
+    if (rosserial_msgs::Log::FATAL >= ROSSERIAL_LOG_LEVEL) {
+      log(rosserial_msgs::Log::FATAL, msg);
+    }
+  }
 
   // This function goes in your loop() function, it handles
   // serial input and callbacks for subscribers.
-  int spinOnce();
-  int getInvalidSizeErrorCount() const;
-  int getChecksumErrorCount() const;
-  int getStateErrorCount() const;
-  int getMalformedMessageErrorCount() const;
-  Time now() const;
-  bool advertise(Publisher& publisher);
+  int spinOnce() {
+    return spin(false, 0);
+  }
+
+  // Like spinOnce(), but stops reading input and running callbacks once
+  // budget_us microseconds have passed, so that a burst of frames does
+  // not hold up a control loop. With setRxQueue(), frames for subscribers
+  // and services are queued as they are read, and their callbacks run
+  // afterwards, highest priority first, while the budget lasts; the rest
+  // run in the next spin. Time syncs, negotiation and parameters are
+  // always handled as they arrive.
+  int spinFor(unsigned long budget_us) {
+    return spin(true, budget_us);
+  }
+
+  int getInvalidSizeErrorCount() const {
+    return invalid_size_error_count_;
+  }
+
+  int getChecksumErrorCount() const {
+    return checksum_error_count_;
+  }
+
+  // After a bad checksum or length, re-scan the bytes of the failed frame
+  // for the start of the next one instead of only looking at new input.
+  // On by default.
+  void setResync(bool resync) {
+    resync_ = resync;
+  }
+
+  // Reject a frame as soon as its header names a topic the node has no
+  // use for, instead of after reading its payload, so that a false sync
+  // marker in noise costs few bytes. Such frames count as invalid size
+  // errors. Off by default.
+  void setHeaderCheck(bool header_check) {
+    header_check_ = header_check;
+  }
+
+  int getStateErrorCount() const {
+    return state_error_count_;
+  }
+
+  int getMalformedMessageErrorCount() const {
+    return malformed_message_error_count_;
+  }
+
+#if ROSSERIAL_DIAGNOSTICS
+  const DurationHistogram& getSpinTimeHistogram() const {
+    return spin_time_;
+  }
+
+  const DurationHistogram& getCallbackTimeHistogram() const {
+    return callback_time_;
+  }
+#endif
+
+  Time now() const {
+    return clock_.toHostTime(hardware_->timeMicros());
+  }
+
+  // Milliseconds between time syncs. The clock model corrects for skew, so
+  // long periods keep now() accurate while using less of the link. The
+  // host drops the connection when it hears no sync request for a while
+  // (15 s for rosserial_python by default), so stay below that.
+  void setSyncPeriod(unsigned long sync_period) {
+    sync_period_ = sync_period;
+  }
+
+  const ClockModel& getClockModel() const {
+    return clock_;
+  }
+
+  // Offers the host these baud rates after topic negotiation. The host
+  // picks the highest one it supports too, and both switch to it through
+  // setBaud(). rates[0] must be the rate the hardware starts at: the
+  // device returns to it if the first time sync at a new rate goes
+  // unanswered, or the connection is lost. The table must outlive the
+  // node handle.
+  void setBaudRates(const long* rates, int count) {
+    baud_rates_ = rates;
+    baud_rate_count_ = count;
+  }
+
+  // Frame errors between two time syncs above which the device offers the
+  // host only rates below the current one. 10 by default.
+  void setBaudErrorThreshold(int threshold) {
+    baud_error_threshold_ = threshold;
+  }
+
+  bool advertise(Publisher& publisher) {
+    // TODO(damonkohler): Pull out a publisher registry or keep track of
+    // the next available ID.
+    for (int i = 0; i < kMaxPublishers; i++) {
+      if (publishers[i] == 0) {  // empty slot
+        publishers[i] = &publisher;
+        publisher.setId(i + 100 + kMaxSubscribers);
+        publisher.setNodeOutput(&node_output_);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Fails to compile unless every MsgT fits in one outgoing frame, e.g.
+  // NodeHandle::checkMessageFits<std_msgs::Time>(). Messages with strings
+  // or unbounded arrays never pass.
+  template<class MsgT>
+  static void checkMessageFits() {
+    (void) sizeof(StaticCheck<(MsgT::kMaxSerializedSize >= 0 &&
+        MsgT::kMaxSerializedSize <= NodeOutput_<HardwareT, OutputSize>::kMaxPayloadSize)>);
+  }
+
+  // Registers a publisher whose newest sample is sent by spinOnce() when
+  // the link has room; see CoalescingPublisher.
+  bool advertise(CoalescingPublisher& publisher) {
+    if (!advertise(static_cast<Publisher&>(publisher))) {
+      return false;
+    }
+    publisher.setNext(coalescing_);
+    coalescing_ = &publisher;
+    return true;
+  }
+
+  // Makes publish() queue frames in tx_queue and return immediately. The
+  // queue is drained at the end of every spinOnce(), or by flush().
+  void setTxQueue(TxQueue* tx_queue) {
+    node_output_.setTxQueue(tx_queue);
+  }
+
+  // Lets spinFor() defer callbacks that do not fit in its time budget.
+  void setRxQueue(RxQueue* rx_queue) {
+    rx_queue_ = rx_queue;
+  }
+
+  // Makes publish() collect topic messages into batched frames, sent when
+  // the output buffer fills up and at the end of every spinOnce(). Needs a
+  // host that unpacks TOPIC_BATCH frames.
+  void setBatching(bool batching) {
+    node_output_.setBatching(batching);
+  }
+
+  void flush() {
+    node_output_.flush();
+  }
 
   // Register a subscriber with the node
   template<typename MsgT>
@@ -85,42 +324,194 @@ class NodeHandle {
     return registerReceiver((MsgReceiver*) &s);
   }
 
+  template<typename MsgT>
+  bool subscribe(ViewSubscriber<MsgT> &s) {
+    return registerReceiver((MsgReceiver*) &s);
+  }
+
   template<typename SrvReq, typename SrvResp>
   bool advertiseService(ServiceServer<SrvReq, SrvResp>& srv) {
-    srv.node_output_ = &node_output_;
+    srv.setNodeOutput(&node_output_);
     return registerReceiver((MsgReceiver*) &srv);
   }
 
-  bool connected();
-  bool getParam(const char* name, int* param, int length=1);
-  bool getParam(const char* name, float* param, int length=1);
-  bool getParam(const char* name, char** param, int length=1);
+  template<typename SrvReq, typename SrvResp>
+  bool serviceClient(ServiceClient<SrvReq, SrvResp>& srv) {
+    srv.setNodeOutput(&node_output_);
+    return registerReceiver((MsgReceiver*) &srv);
+  }
+
+  bool connected() {
+    return connected_;
+  }
+
+  // Fetches the parameters named by cache in one request whenever the
+  // host (re)connects, so that they can be read with cache->getParam()
+  // without blocking. The request is repeated until it is answered.
+  void setParamCache(ParamCache* cache) {
+    param_cache_ = cache;
+  }
+
+  bool getParam(const char* name, int* param, int length=1) {
+    if (requestParam(name) && length == req_param_resp.ints_length) {
+      for (int i = 0; i < length; i++) {
+        param[i] = req_param_resp.ints[i];
+      }
+      return true;
+    }
+    return false;
+  }
+
+  bool getParam(const char* name, float* param, int length=1) {
+    if (requestParam(name) && length == req_param_resp.floats_length) {
+      for (int i = 0; i < length; i++) {
+        param[i] = req_param_resp.floats[i];
+      }
+      return true;
+    }
+    return false;
+  }
+
+  bool getParam(const char* name, char** param, int length=1) {
+    if (requestParam(name) && length == req_param_resp.strings_length) {
+      for (int i = 0; i < length; i++) {
+        strcpy(param[i], req_param_resp.strings[i]);
+      }
+      return true;
+    }
+    return false;
+  }
+
+  // Registers the format strings of logBinary() with the host: format i
+  // is formats[i], a string in ROSSERIAL_PROGMEM. The table must outlive
+  // the node handle.
+  void setLogFormats(const char* const* formats, int count) {
+    log_formats_ = formats;
+    log_format_count_ = count;
+  }
+
+  // Logs format number format of setLogFormats() with up to four
+  // arguments, which the host formats; see LogRecord for the argument
+  // types. Cheaper than formatting on the device and sending the text,
+  // e.g. nh.logBinary<rosserial_msgs::Log::WARN>(kLowBattery, millivolts).
+  // Calls below ROSSERIAL_LOG_LEVEL compile to nothing.
+  template<int Level>
+  void logBinary(int format) {
+    if (Level >= ROSSERIAL_LOG_LEVEL) {
+      LogRecord record(Level, format);
+      node_output_.publish(rosserial_msgs::TopicInfo::ID_BINARY_LOG, &record);
+    }
+  }
+
+  template<int Level, class A>
+  void logBinary(int format, A a) {
+    if (Level >= ROSSERIAL_LOG_LEVEL) {
+      LogRecord record(Level, format);
+      record.append(a);
+      node_output_.publish(rosserial_msgs::TopicInfo::ID_BINARY_LOG, &record);
+    }
+  }
+
+  template<int Level, class A, class B>
+  void logBinary(int format, A a, B b) {
+    if (Level >= ROSSERIAL_LOG_LEVEL) {
+      LogRecord record(Level, format);
+      record.append(a);
+      record.append(b);
+      node_output_.publish(rosserial_msgs::TopicInfo::ID_BINARY_LOG, &record);
+    }
+  }
+
+  template<int Level, class A, class B, class C>
+  void logBinary(int format, A a, B b, C c) {
+    if (Level >= ROSSERIAL_LOG_LEVEL) {
+      LogRecord record(Level, format);
+      record.append(a);
+      record.append(b);
+      record.append(c);
+      node_output_.publish(rosserial_msgs::TopicInfo::ID_BINARY_LOG, &record);
+    }
+  }
+
+  template<int Level, class A, class B, class C, class D>
+  void logBinary(int format, A a, B b, C c, D d) {
+    if (Level >= ROSSERIAL_LOG_LEVEL) {
+      LogRecord record(Level, format);
+      record.append(a);
+      record.append(b);
+      record.append(c);
+      record.append(d);
+      node_output_.publish(rosserial_msgs::TopicInfo::ID_BINARY_LOG, &record);
+    }
+  }
 
  private:
-  // Synchronize clocks every n milliseconds.
-  static const int kSyncPeriod = 5000;
-  // Connection times out after n milliseconds without a time sync.
-  static const int kConnectionTimeout = 6000;
-  static const int kMaxSubscribers = 25;
-  static const int kMaxPublishers = 25;
-  static const int kInputSize = 512;
+  // Synchronize clocks every n milliseconds unless set otherwise.
+  static const unsigned long kDefaultSyncPeriod = 5000;
+  // Milliseconds the host has to answer a time sync.
+  static const unsigned long kSyncTimeout = 1000;
+  static const int kMaxSubscribers = MaxSubscribers;
+  static const int kMaxPublishers = MaxPublishers;
+  static const int kInputSize = InputSize;
   static const int kMaxBytesPerSpin = 512;
+  // Sync flags, topic ID and length before the payload of a frame.
+  static const int kFrameHeaderSize = 6;
+  // Milliseconds before an unanswered parameter batch is requested again.
+  static const unsigned long kParamBatchTimeout = 1000;
+  static const uint32_t kFnvOffsetBasis = 2166136261u;
+  static const uint32_t kFnvPrime = 16777619u;
+  // Format ID of kTimeSyncLogFormat, above those of setLogFormats().
+  static const uint16_t kTimeSyncLogFormatId = 0xffff;
+  static const int kDefaultBaudErrorThreshold = 10;
+#if ROSSERIAL_DIAGNOSTICS
+  // Milliseconds between link statistics reports.
+  static const unsigned long kDiagnosticsPeriod = 5000;
+  // Topics per report; a report then takes 199 bytes of output buffer.
+  static const int kDiagnosticsTopics = 4;
+#endif
 
-  Hardware* hardware_;
-  NodeOutput node_output_;
+  HardwareT* hardware_;
+  NodeOutput_<HardwareT, OutputSize> node_output_;
   bool connected_;
   bool param_received_;
   rosserial_msgs::RequestParamResponse req_param_resp;
-  // millis() when the time sync was requested.
+  ParamCache* param_cache_;
+  bool param_batch_pending_;
+  // time() when the parameter batch was last requested.
+  unsigned long param_batch_time_;
+  const char* const* log_formats_;
+  int log_format_count_;
+  const long* baud_rates_;
+  int baud_rate_count_;
+  // Index of the current rate in baud_rates_.
+  int baud_index_;
+  int baud_error_threshold_;
+  // Whether the rate was switched and the host has not been heard at it.
+  bool baud_switch_pending_;
+  // time() when the rate was switched.
+  unsigned long baud_switch_time_;
+  // linkErrors() when the last time sync completed.
+  int link_errors_at_sync_;
+  unsigned long sync_period_;
+  bool time_sync_pending_;
+  // timeMicros() when the time sync was requested.
   unsigned long time_sync_start_;
+  // time() when the last time sync completed.
   unsigned long time_sync_end_;
-  Time sync_time_;
-  unsigned char message_in[kInputSize];
+  ClockModel clock_;
+  // The frame being received, from its first 0xff, followed by bytes
+  // still to be re-scanned at [replay_index_, replay_end_).
+  unsigned char frame_in_[kFrameHeaderSize + kInputSize + 1];
   Publisher* publishers[kMaxPublishers];
   MsgReceiver* receivers[kMaxSubscribers];
 
   // State machine variables for spinOnce.
   PacketState state_;
+  int frame_length_;
+  int replay_index_;
+  int replay_end_;
+  bool resync_;
+  bool header_check_;
   uint16_t remaining_data_bytes_;
   int topic_;
   int data_index_;
@@ -130,17 +521,590 @@ class NodeHandle {
   int state_error_count_;
   int malformed_message_error_count_;
   int total_receivers_;
+  // Intrusive list of coalescing publishers, and where the next
+  // sendCoalesced() starts so that a busy link is shared round-robin.
+  CoalescingPublisher* coalescing_;
+  CoalescingPublisher* next_coalescing_;
+  RxQueue* rx_queue_;
+  // Whether dispatchQueued() is running a callback, which may spin again.
+  bool dispatching_queued_;
+#if ROSSERIAL_DIAGNOSTICS
+  DurationHistogram spin_time_;
+  DurationHistogram callback_time_;
+  // time() of the last link statistics report.
+  unsigned long diagnostics_time_;
+  // Topic ID - 100 where the next report's topics start.
+  int next_diagnostics_topic_;
+#endif
+
+  // spinOnce(), or spinFor(budget_us) if budgeted.
+  int spin(bool budgeted, unsigned long budget_us) {
+    unsigned long current_time = hardware_->time();
+    unsigned long spin_start = hardware_->timeMicros();
+
+    if (baud_switch_pending_ && current_time - baud_switch_time_ > kSyncTimeout) {
+      // The host can't be heard at the new rate.
+      restoreBaud();
+    }
+    if (connected_) {
+      // Connection times out when a time sync is not answered within
+      // kSyncTimeout milliseconds.
+      if (current_time - time_sync_end_ > sync_period_ + kSyncTimeout) {
+        connected_ = false;
+        time_sync_pending_ = false;
+        clock_.reset();
+        reset();
+        restoreBaud();
+      }
+      // Sync time every sync_period_ milliseconds.
+      if (current_time - time_sync_end_ > sync_period_) {
+        requestTimeSync();
+      }
+      if (param_batch_pending_ &&
+          current_time - param_batch_time_ > kParamBatchTimeout) {
+        requestParamBatch();
+      }
+    }
+
+    // Frames left over from spinFor() are older than any input.
+    if (!budgeted) {
+      dispatchQueued(false, spin_start, 0);
+    }
+    bool defer = budgeted && rx_queue_ != 0;
+
+    unsigned char* message_in = frame_in_ + kFrameHeaderSize;
+    // Counts re-scanned bytes too, which bounds the work of a spin.
+    int byte_count = 0;
+    while (byte_count < kMaxBytesPerSpin) {
+      if (budgeted && state_ == STATE_FIRST_FF &&
+          hardware_->timeMicros() - spin_start >= budget_us) {
+        break;
+      }
+      if (state_ == STATE_MESSAGE) {
+        // The header is known, so copy as much of the payload as is
+        // available straight into message_in.
+        int span = remaining_data_bytes_;
+        if (span > kMaxBytesPerSpin - byte_count) {
+          span = kMaxBytesPerSpin - byte_count;
+        }
+        span = readInput(span);
+        if (span <= 0) {
+          break;
+        }
+        for (int i = frame_length_; i < frame_length_ + span; i++) {
+          checksum_ += frame_in_[i];
+        }
+        frame_length_ += span;
+        data_index_ += span;
+        remaining_data_bytes_ -= span;
+        byte_count += span;
+        if (remaining_data_bytes_ == 0) {
+          state_ = STATE_CHECKSUM;
+        }
+        continue;
+      }
+      int input_byte = readInput();
+      if (input_byte < 0) {
+        break;
+      }
+      byte_count++;
+      checksum_ += input_byte;
+      frame_in_[frame_length_++] = input_byte;
+      switch (state_) {
+        case STATE_FIRST_FF:
+          if (input_byte == 0xff) {
+            state_ = STATE_SECOND_FF;
+          } else {
+            state_error_count_++;
+            reset();
+          }
+          break;
+        case STATE_SECOND_FF:
+          if (input_byte == 0xff) {
+            state_ = STATE_TOPIC_LOW;
+          } else {
+            // Not a 0xff either, so there is nothing to re-scan.
+            state_error_count_++;
+            reset();
+          }
+          break;
+        case STATE_TOPIC_LOW:
+          // This is the first byte to be included in the checksum.
+          checksum_ = input_byte;
+          topic_ = input_byte;
+          state_ = STATE_TOPIC_HIGH;
+          break;
+        case STATE_TOPIC_HIGH:
+          topic_ += input_byte << 8;
+          state_ = STATE_SIZE_LOW;
+          break;
+        case STATE_SIZE_LOW:
+          remaining_data_bytes_ = input_byte;
+          state_ = STATE_SIZE_HIGH;
+          break;
+        case STATE_SIZE_HIGH:
+          remaining_data_bytes_ += static_cast<uint16_t>(input_byte) << 8;
+          if (remaining_data_bytes_ > kInputSize || (header_check_ && !acceptsTopic(topic_))) {
+            // Protect against buffer overflow, and skip false sync
+            // markers before their length swallows the frames after them.
+            ++invalid_size_error_count_;
+            resync();
+          } else if (remaining_data_bytes_ == 0) {
+            state_ = STATE_CHECKSUM;
+          } else {
+            state_ = STATE_MESSAGE;
+          }
+          break;
+        case STATE_CHECKSUM:
+          if ((checksum_ % 256) != 255) {
+            ++checksum_error_count_;
+            resync();
+            break;
+          }
+          if (topic_ == TOPIC_NEGOTIATION) {
+            requestTimeSync();
+            negotiateTopics(message_in, data_index_);
+            offerBaudRates(0);
+            requestParamBatch();
+          } else if (topic_ == rosserial_msgs::TopicInfo::ID_TIME) {
+            completeTimeSync(message_in);
+            connected_ = true;
+          } else if (topic_ == rosserial_msgs::TopicInfo::ID_PARAMETER_REQUEST) {
+            if (req_param_resp.deserialize(message_in, kInputSize) >= 0) {
+              param_received_ = true;
+            }
+          } else if (topic_ == rosserial_msgs::TopicInfo::ID_BAUD_RATE) {
+            switchBaud(message_in, data_index_);
+          } else if (topic_ == rosserial_msgs::TopicInfo::ID_PARAMETER_BATCH) {
+            if (param_cache_ != 0 && param_cache_->store(message_in, data_index_)) {
+              param_batch_pending_ = false;
+            }
+          } else if (topic_ >= 100 && topic_ - 100 < kMaxSubscribers &&
+                     receivers[topic_ - 100] != 0) {
+            if (!defer) {
+              dispatch(topic_, message_in, data_index_);
+            } else if (!rx_queue_->push(topic_, receivers[topic_ - 100]->getPriority(),
+                                        message_in, data_index_)) {
+#if ROSSERIAL_DIAGNOSTICS
+              receivers[topic_ - 100]->getCounters().count(-1);
+#endif
+            }
+          } else {
+            ++checksum_error_count_;
+          }
+          reset();
+          break;
+        default:;
+          reset();
+          break;
+      }
+    }
+    if (defer) {
+      dispatchQueued(true, spin_start, budget_us);
+    }
+    if (connected_) {
+      sendCoalesced(current_time);
+#if ROSSERIAL_DIAGNOSTICS
+      if (current_time - diagnostics_time_ > kDiagnosticsPeriod) {
+        sendDiagnostics();
+        diagnostics_time_ = current_time;
+      }
+#endif
+    }
+    node_output_.flush();
+#if ROSSERIAL_DIAGNOSTICS
+    spin_time_.add(hardware_->timeMicros() - spin_start);
+#endif
+    return byte_count;
+  }
+
+  // Runs the callbacks of queued frames, highest priority first, until
+  // the queue is empty or, if budgeted, budget_us have passed since start.
+  // A spin from within one of those callbacks leaves the queue alone, as
+  // the frame being dispatched is only popped once its callback returns.
+  void dispatchQueued(bool budgeted, unsigned long start, unsigned long budget_us) {
+    if (rx_queue_ == 0 || dispatching_queued_) {
+      return;
+    }
+    dispatching_queued_ = true;
+    int topic;
+    unsigned char* data;
+    int length;
+    while ((!budgeted || hardware_->timeMicros() - start < budget_us) &&
+           rx_queue_->front(&topic, &data, &length)) {
+      dispatch(topic, data, length);
+      rx_queue_->pop();
+    }
+    dispatching_queued_ = false;
+  }
+
+  void dispatch(int topic, unsigned char* data, int length) {
+    MsgReceiver* receiver = receivers[topic - 100];
+#if ROSSERIAL_DIAGNOSTICS
+    unsigned long callback_start = hardware_->timeMicros();
+#endif
+    bool success = receiver->receive(data, length);
+#if ROSSERIAL_DIAGNOSTICS
+    callback_time_.add(hardware_->timeMicros() - callback_start);
+    receiver->getCounters().count(success ? length : -1);
+#endif
+    if (!success) {
+      ++malformed_message_error_count_;
+    }
+  }
+
+  // Lists every topic for the host, unless the host offers the hash of
+  // the topic table it kept from an earlier connection and the table is
+  // unchanged. Either way the host is sent the current hash to keep.
+  void negotiateTopics(unsigned char* data, int length) {
+    std_msgs::UInt32 topic_hash;
+    topic_hash.data = topicHash();
+    std_msgs::UInt32 host_hash;
+    if (host_hash.deserialize(data, length) < 0 || host_hash.data != topic_hash.data) {
+      listTopics();
+    }
+    node_output_.publish(rosserial_msgs::TopicInfo::ID_TOPIC_HASH, &topic_hash);
+  }
+
+  void listTopics() {
+    rosserial_msgs::TopicInfo topic_info;
+    topic_info.md5_checksum = const_cast<char*>("");
+    // Slots are allocated sequentially and contiguously. We can break
+    // out early.
+    for (int i = 0; i < kMaxPublishers && publishers[i] != 0; i++) {
+      topic_info.topic_id = publishers[i]->getId();
+      topic_info.topic_name = const_cast<char*>(publishers[i]->getTopicName());
+      topic_info.message_type = const_cast<char*>(publishers[i]->getMessageType());
+      TopicListing listing(&topic_info, publishers[i]->getEncoding());
+      node_output_.publish(TOPIC_PUBLISHERS, &listing);
+    }
+    for (int i = 0; i < kMaxSubscribers && receivers[i] != 0; i++) {
+      topic_info.topic_id = receivers[i]->getId();
+      topic_info.topic_name = const_cast<char*>(receivers[i]->getTopicName());
+      topic_info.message_type = const_cast<char*>(receivers[i]->getMessageType());
+      node_output_.publish(receivers[i]->getTopicType(), &topic_info);
+    }
+    LogFormat time_sync_format(kTimeSyncLogFormatId, kTimeSyncLogFormat);
+    node_output_.publish(rosserial_msgs::TopicInfo::ID_LOG_FORMAT, &time_sync_format);
+    for (int i = 0; i < log_format_count_; i++) {
+      LogFormat format(i, log_formats_[i]);
+      node_output_.publish(rosserial_msgs::TopicInfo::ID_LOG_FORMAT, &format);
+    }
+  }
+
+  // 32 bit FNV-1a hash of the ID, name, type and encoding of every topic,
+  // and of the log formats, in the order listTopics() sends them. Hosts compute
+  // the same hash over the listing they receive.
+  uint32_t topicHash() const {
+    uint32_t hash = kFnvOffsetBasis;
+    for (int i = 0; i < kMaxPublishers && publishers[i] != 0; i++) {
+      hash = hashTopic(hash, publishers[i]->getId(), publishers[i]->getTopicName(),
+                       publishers[i]->getMessageType(), publishers[i]->getEncoding());
+    }
+    for (int i = 0; i < kMaxSubscribers && receivers[i] != 0; i++) {
+      hash = hashTopic(hash, receivers[i]->getId(), receivers[i]->getTopicName(),
+                       receivers[i]->getMessageType());
+    }
+    hash = hashLogFormat(hash, kTimeSyncLogFormatId, kTimeSyncLogFormat);
+    for (int i = 0; i < log_format_count_; i++) {
+      hash = hashLogFormat(hash, i, log_formats_[i]);
+    }
+    return hash;
+  }
+
+  // The encoding is only hashed if there is one, which keeps the hashes
+  // of plain topic tables as they were.
+  static uint32_t hashTopic(uint32_t hash, int id, const char* name, const char* type,
+                            uint8_t encoding = rosserial_msgs::TopicInfo::ENCODING_NONE) {
+    hash = hashByte(hash, id & 0xff);
+    hash = hashByte(hash, (id >> 8) & 0xff);
+    // Names and types are hashed with their terminators so that their
+    // boundaries count.
+    do {
+      hash = hashByte(hash, *name);
+    } while (*name++ != 0);
+    do {
+      hash = hashByte(hash, *type);
+    } while (*type++ != 0);
+    if (encoding != rosserial_msgs::TopicInfo::ENCODING_NONE) {
+      hash = hashByte(hash, encoding);
+    }
+    return hash;
+  }
+
+  // Hashed like a topic named after the format, with an empty type.
+  static uint32_t hashLogFormat(uint32_t hash, int id, const char* format) {
+    hash = hashByte(hash, id & 0xff);
+    hash = hashByte(hash, (id >> 8) & 0xff);
+    char byte;
+    do {
+      byte = readProgmem(format++);
+      hash = hashByte(hash, byte);
+    } while (byte != 0);
+    return hashByte(hash, 0);
+  }
+
+  static uint32_t hashByte(uint32_t hash, unsigned char byte) {
+    return (hash ^ byte) * kFnvPrime;
+  }
 
-  void negotiateTopics();
-  void setNow(Time& new_now);
-  void requestTimeSync();
-  void completeTimeSync(unsigned char* data);
-  bool registerReceiver(MsgReceiver* receiver);
-  void reset();
-  void log(char byte, const char* msg);
-  bool requestParam(const char* name, int time_out=1000);
+  void sendCoalesced(unsigned long now) {
+    if (coalescing_ == 0) {
+      return;
+    }
+    CoalescingPublisher* start = next_coalescing_ != 0 ? next_coalescing_ : coalescing_;
+    CoalescingPublisher* publisher = start;
+    do {
+      CoalescingPublisher* next = publisher->getNext() != 0 ? publisher->getNext() : coalescing_;
+      int room = node_output_.getRoom();
+      if (publisher->trySend(now, room, node_output_.getCapacity())) {
+        next_coalescing_ = next;
+      }
+      publisher = next;
+    } while (publisher != start);
+  }
+
+#if ROSSERIAL_DIAGNOSTICS
+  // Reports the link counters, and those of up to kDiagnosticsTopics
+  // topics, starting where the last report stopped.
+  void sendDiagnostics() {
+    rosserial_msgs::LinkStatistics statistics;
+    statistics.invalid_size_errors = invalid_size_error_count_;
+    statistics.checksum_errors = checksum_error_count_;
+    statistics.state_errors = state_error_count_;
+    statistics.malformed_message_errors = malformed_message_error_count_;
+    TxQueue* tx_queue = node_output_.getTxQueue();
+    statistics.tx_high_water_mark = tx_queue != 0 ? tx_queue->getHighWaterMark() : 0;
+    statistics.tx_dropped_frames = tx_queue != 0 ? tx_queue->getDroppedFrameCount() : 0;
+    statistics.round_trip_time = clock_.getRoundTripTime();
+    statistics.spin_time_length = DurationHistogram::kBuckets;
+    statistics.spin_time = const_cast<uint32_t*>(spin_time_.getCounts());
+    statistics.callback_time_length = DurationHistogram::kBuckets;
+    statistics.callback_time = const_cast<uint32_t*>(callback_time_.getCounts());
+
+    // Receivers have IDs 100 + i, publishers 100 + kMaxSubscribers + i.
+    const int topic_count = kMaxSubscribers + kMaxPublishers;
+    rosserial_msgs::TopicStatistics topics[kDiagnosticsTopics];
+    int count = 0;
+    int index = next_diagnostics_topic_;
+    for (int i = 0; i < topic_count && count < kDiagnosticsTopics; i++) {
+      const TopicCounters* counters = 0;
+      if (index < kMaxSubscribers) {
+        if (receivers[index] != 0) {
+          counters = &receivers[index]->getCounters();
+        }
+      } else if (publishers[index - kMaxSubscribers] != 0) {
+        counters = &publishers[index - kMaxSubscribers]->getCounters();
+      }
+      if (counters != 0) {
+        topics[count].topic_id = 100 + index;
+        topics[count].frames = counters->frames;
+        topics[count].bytes = counters->bytes;
+        topics[count].dropped = counters->dropped;
+        ++count;
+      }
+      index = index + 1 < topic_count ? index + 1 : 0;
+    }
+    next_diagnostics_topic_ = index;
+    statistics.topics_length = count;
+    statistics.topics = topics;
+    node_output_.publish(rosserial_msgs::TopicInfo::ID_DIAGNOSTICS, &statistics);
+  }
+#endif
+
+  void requestTimeSync() {
+    if (time_sync_pending_) {
+      // A time sync request is already in flight.
+      return;
+    }
+    time_sync_pending_ = true;
+    time_sync_start_ = hardware_->timeMicros();
+    // TODO(damonkohler): Why publish an empty message here?
+    std_msgs::Time time;
+    node_output_.publish(rosserial_msgs::TopicInfo::ID_TIME, &time);
+  }
+
+  void completeTimeSync(unsigned char* data) {
+    unsigned long time_sync_received = hardware_->timeMicros();
+    time_sync_end_ = hardware_->time();
+    std_msgs::Time time;
+    if (time.deserialize(data, kInputSize) < 0) {
+      return;
+    }
+    if (time_sync_pending_) {
+      // A rejected round trip still shows the host is there.
+      clock_.update(time_sync_start_, time.data, time_sync_received);
+      time_sync_pending_ = false;
+    }
+    int link_errors = linkErrors();
+    if (baud_switch_pending_) {
+      // The host is heard at the new rate, so let it hear the device.
+      baud_switch_pending_ = false;
+      requestTimeSync();
+    } else if (baud_index_ != 0 && link_errors - link_errors_at_sync_ > baud_error_threshold_) {
+      offerBaudRates(baud_rates_[baud_index_]);
+    }
+    link_errors_at_sync_ = link_errors;
+    Time synced = now();
+    logBinary<rosserial_msgs::Log::DEBUG>(kTimeSyncLogFormatId, synced.sec, synced.nsec);
+  }
+
+  // Offers the host the baud rates below limit, or all of them if 0.
+  void offerBaudRates(long limit) {
+    if (baud_rate_count_ == 0) {
+      return;
+    }
+    BaudRateOffer offer(baud_rates_, baud_rate_count_, limit);
+    node_output_.publish(rosserial_msgs::TopicInfo::ID_BAUD_RATE, &offer);
+  }
+
+  // Switches to the rate the host picked, if it is one of baud_rates_.
+  void switchBaud(unsigned char* data, int length) {
+    std_msgs::UInt32 rate;
+    if (rate.deserialize(data, length) < 0) {
+      return;
+    }
+    int index = 0;
+    while (index < baud_rate_count_ && static_cast<uint32_t>(baud_rates_[index]) != rate.data) {
+      index++;
+    }
+    if (index == baud_rate_count_ || index == baud_index_) {
+      return;
+    }
+    // Whatever is still buffered goes out at the old rate.
+    node_output_.flush();
+    hardware_->setBaud(baud_rates_[index]);
+    hardware_->init();
+    baud_index_ = index;
+    reset();
+    replay_index_ = replay_end_ = 0;
+    baud_switch_pending_ = index != 0;
+    baud_switch_time_ = hardware_->time();
+    // The host confirms the rate with a time sync of its own once it has
+    // switched too; a request sent before then would be lost.
+    time_sync_pending_ = false;
+  }
+
+  void restoreBaud() {
+    baud_switch_pending_ = false;
+    if (baud_index_ != 0) {
+      hardware_->setBaud(baud_rates_[0]);
+      hardware_->init();
+      baud_index_ = 0;
+    }
+  }
+
+  int linkErrors() const {
+    return checksum_error_count_ + invalid_size_error_count_;
+  }
+
+  bool registerReceiver(MsgReceiver* receiver) {
+    if (total_receivers_ >= kMaxSubscribers) {
+      return false;
+    }
+    receivers[total_receivers_] = receiver;
+    receiver->setId(100 + total_receivers_);
+    total_receivers_++;
+    return true;
+  }
+
+  // Next input byte: bytes to re-scan first, then the hardware's.
+  int readInput() {
+    if (replay_index_ < replay_end_) {
+      return frame_in_[replay_index_++];
+    }
+    return hardware_->read();
+  }
+
+  // Appends up to max input bytes to the frame. Returns their number.
+  int readInput(int max) {
+    if (replay_index_ < replay_end_) {
+      int count = replay_end_ - replay_index_;
+      if (count > max) {
+        count = max;
+      }
+      memmove(frame_in_ + frame_length_, frame_in_ + replay_index_, count);
+      replay_index_ += count;
+      return count;
+    }
+    return hardware_->read(frame_in_ + frame_length_, max);
+  }
+
+  // Gives up on the frame received so far. Its bytes after the first
+  // 0xff, and any bytes not re-scanned yet, are moved together and
+  // scanned again for the next sync marker, so a frame that started
+  // inside a damaged one isn't lost.
+  void resync() {
+    if (resync_) {
+      int pending = replay_end_ - replay_index_;
+      memmove(frame_in_ + frame_length_, frame_in_ + replay_index_, pending);
+      replay_index_ = 1;
+      replay_end_ = frame_length_ + pending;
+    }
+    reset();
+  }
+
+  // Whether a frame for topic could be handled at all.
+  bool acceptsTopic(int topic) const {
+    if (topic >= 100) {
+      return topic - 100 < total_receivers_;
+    }
+    return topic == TOPIC_NEGOTIATION || topic == rosserial_msgs::TopicInfo::ID_TIME ||
+           topic == rosserial_msgs::TopicInfo::ID_PARAMETER_REQUEST ||
+           topic == rosserial_msgs::TopicInfo::ID_PARAMETER_BATCH ||
+           topic == rosserial_msgs::TopicInfo::ID_BAUD_RATE;
+  }
+
+  void reset() {
+    state_ = STATE_FIRST_FF;
+    frame_length_ = 0;
+    remaining_data_bytes_ = 0;
+    topic_ = 0;
+    data_index_ = 0;
+    checksum_ = 0;
+  }
+
+  void log(char byte, const char* msg) {
+    rosserial_msgs::Log l;
+    l.level = byte;
+    l.msg = const_cast<char*>(msg);
+    this->node_output_.publish(rosserial_msgs::TopicInfo::ID_LOG, &l);
+  }
+
+  void requestParamBatch() {
+    if (param_cache_ == 0) {
+      return;
+    }
+    rosserial_msgs::RequestParamsRequest req;
+    req.names_length = param_cache_->getCount();
+    req.names = const_cast<char**>(param_cache_->getNames());
+    node_output_.publish(rosserial_msgs::TopicInfo::ID_PARAMETER_BATCH, &req);
+    param_batch_pending_ = true;
+    param_batch_time_ = hardware_->time();
+  }
+
+  bool requestParam(const char* name, int time_out=1000) {
+    param_received_ = false;
+    rosserial_msgs::RequestParamRequest req;
+    req.name  = const_cast<char*>(name);
+    node_output_.publish(rosserial_msgs::TopicInfo::ID_PARAMETER_REQUEST, &req);
+    unsigned long start_time = hardware_->time();
+    while(!param_received_) {
+      spinOnce();
+      if (hardware_->time() - start_time > time_out) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  NodeHandle_(const NodeHandle_&);
+  void operator=(const NodeHandle_&);
 };
 
+// The default node handle, bound to the Hardware interface at run time.
+typedef NodeHandle_<Hardware> NodeHandle;
+
 }  // namespace ros
 
 #endif  // ROS_NODE_HANDLE_H_
@@ -37,53 +37,195 @@
 
 #include "msg.h"
 #include "hardware.h"
+#include "rosserial_ids.h"
+#include "tx_queue.h"
 
 namespace ros {
 
-class NodeOutput {
+// Interface used by publishers and services to send messages, independent
+// of the hardware and buffer size the node was built with.
+class NodeOutputBase {
+ public:
+  // Sync flags, topic ID, length and checksum around every payload.
+  static const int kFrameOverhead = 7;
+
+  virtual ~NodeOutputBase() {}
+  virtual int publish(int id, Msg* msg) = 0;
+};
+
+template<class HardwareT, int OutputSize = 512>
+class NodeOutput_ : public NodeOutputBase {
  private:
-  static const int kOutputSize = 512;
+  static const int kOutputSize = OutputSize;
 
  public:
-  NodeOutput(Hardware* hardware) : hardware_(hardware) {}
+  // Largest message that fits in a frame.
+  static const int kMaxPayloadSize = OutputSize - kFrameOverhead;
+
+  NodeOutput_(HardwareT* hardware)
+      : hardware_(hardware), tx_queue_(0), batching_(false), batch_length_(0),
+        capacity_(-1) {}
 
-  int publish(int id, Msg* msg) {
+  // Queue frames in tx_queue instead of writing them synchronously. The
+  // queue is drained by flush(). Pass 0 to go back to synchronous writes.
+  // Frames still queued in a previous queue are not sent.
+  void setTxQueue(TxQueue* tx_queue) {
+    tx_queue_ = tx_queue;
+    capacity_ = -1;
+  }
+
+  TxQueue* getTxQueue() {
+    return tx_queue_;
+  }
+
+  // Collect topic messages into TOPIC_BATCH frames, each holding as many
+  // (topic, length, payload) records as fit in the output buffer. This
+  // saves 3 bytes per message and needs a host that understands batches.
+  // Protocol messages are never batched.
+  void setBatching(bool batching) {
+    if (!batching) {
+      flushBatch();
+    }
+    batching_ = batching;
+  }
+
+  // Bytes that can be sent without blocking or dropping frames: the free
+  // space in the transmit queue, else in the hardware's write buffer. -1
+  // if unknown.
+  int getRoom() {
+    int room = tx_queue_ != 0 ? tx_queue_->getSpace() : hardware_->availableForWrite();
+    if (room > capacity_) {
+      capacity_ = room;
+    }
+    return room;
+  }
+
+  // The most room getRoom() has reported, which once the buffer has been
+  // empty is its size. -1 if unknown.
+  int getCapacity() {
+    return capacity_;
+  }
+
+  // Sends the pending batch, then writes as much of the transmit queue as
+  // the hardware can take.
+  void flush() {
+    flushBatch();
+    if (tx_queue_ != 0) {
+      tx_queue_->drain(hardware_);
+    }
+  }
+
+  // Messages too big for a frame fail in serialize(), so their length
+  // isn't computed up front.
+  virtual int publish(int id, Msg* msg) {
+    if (batching_ && id >= 100) {
+      return addToBatch(id, msg);
+    }
+    // Keep frames in publish order.
+    flushBatch();
     // Leave 6 bytes for the header, 1 byte for the checksum.
-    int length = msg->serialize(message_out + 6, kOutputSize - 7);
+    int length = msg->serialize(message_out + 6, kMaxPayloadSize);
     if (length < 0) {
       // Serialization failed (buffer limit exceeded).
       return -1;
     }
+    return sendFrame(message_out, id, length);
+  }
+
+ private:
+  // Size of the topic ID and length that precede each batch record.
+  static const int kRecordHeaderSize = 4;
+
+  HardwareT* hardware_;
+  TxQueue* tx_queue_;
+  bool batching_;
+  // Bytes of batch records in message_out, after the frame header.
+  int batch_length_;
+  int capacity_;
+  unsigned char message_out[kOutputSize];
+
+  // Serializes the message after the last record, or if it doesn't fit,
+  // sends the batch and tries again in an empty one.
+  int addToBatch(int id, Msg* msg) {
+    unsigned char* record = message_out + 6 + batch_length_;
+    int room = kMaxPayloadSize - batch_length_ - kRecordHeaderSize;
+    int length = room < 0 ? -1 : msg->serialize(record + kRecordHeaderSize, room);
+    if (length < 0 && batch_length_ > 0) {
+      flushBatch();
+      record = message_out + 6;
+      length = msg->serialize(record + kRecordHeaderSize, kMaxPayloadSize - kRecordHeaderSize);
+    }
+    if (length < 0) {
+      // Too big to batch; send it on its own.
+      length = msg->serialize(message_out + 6, kMaxPayloadSize);
+      if (length < 0) {
+        return -1;
+      }
+      return sendFrame(message_out, id, length);
+    }
+    record[0] = (unsigned char) (id & 255);
+    record[1] = (unsigned char) (id >> 8);
+    record[2] = (unsigned char) (length & 255);
+    record[3] = (unsigned char) (length >> 8);
+    batch_length_ += kRecordHeaderSize + length;
+    return kRecordHeaderSize + length;
+  }
+
+  void flushBatch() {
+    if (batch_length_ == 0) {
+      return;
+    }
+    if (message_out[8] + (message_out[9] << 8) + kRecordHeaderSize == batch_length_) {
+      // A single record already has the layout of a frame 4 bytes in.
+      sendFrame(message_out + 4, message_out[6] + (message_out[7] << 8),
+                batch_length_ - kRecordHeaderSize);
+    } else {
+      sendFrame(message_out, TOPIC_BATCH, batch_length_);
+    }
+    batch_length_ = 0;
+  }
+
+  // Fills in the header and checksum around length payload bytes at
+  // frame + 6, then writes or queues the frame.
+  int sendFrame(unsigned char* frame, int id, int length) {
     // Build the header
     // Sync flags
-    message_out[0] = 0xff;
-    message_out[1] = 0xff;
+    frame[0] = 0xff;
+    frame[1] = 0xff;
     // Topic ID
-    message_out[2] = (unsigned char) (id & 255);
-    message_out[3] = (unsigned char) (id >> 8);
+    frame[2] = (unsigned char) (id & 255);
+    frame[3] = (unsigned char) (id >> 8);
     // Data length
-    message_out[4] = (unsigned char) (length & 255);
-    message_out[5] = (unsigned char) (length >> 8);
+    frame[4] = (unsigned char) (length & 255);
+    frame[5] = (unsigned char) (length >> 8);
 
     // calculate checksum
     int chk = 0;
     for (int i = 2; i < length + 6; i++) {
-      chk += message_out[i];
+      chk += frame[i];
     }
     length += 6;  // Include the header length.
-    message_out[length++] = 255 - (chk % 256);  // Add checksum byte and increase length.
-    hardware_->write(message_out, length);
+    frame[length++] = 255 - (chk % 256);  // Add checksum byte and increase length.
+    if (tx_queue_ != 0) {
+      // IDs below 100 are protocol frames (time sync, logging,
+      // negotiation), which go ahead of topic data. Batches and link
+      // statistics are bulk data.
+      bool priority = id < 100 && id != TOPIC_BATCH && id != TOPIC_DIAGNOSTICS;
+      if (!tx_queue_->enqueue(frame, length, priority)) {
+        return -1;
+      }
+      return length;
+    }
+    hardware_->write(frame, length);
     return length;
   }
 
- private:
-  Hardware* hardware_;
-  unsigned char message_out[kOutputSize];
-
-  NodeOutput(const NodeOutput&);
-  void operator=(const NodeOutput&);
+  NodeOutput_(const NodeOutput_&);
+  void operator=(const NodeOutput_&);
 };
 
+typedef NodeOutput_<Hardware> NodeOutput;
+
 }  // namespace ros
 
 #endif
@@ -0,0 +1,148 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ros/param_cache.h"
+
+#include <string.h>
+
+namespace ros {
+
+ParamCache::ParamCache(const char** names, int count,
+                       unsigned char* buffer, int size)
+    : names_(names),
+      count_(count),
+      buffer_(buffer),
+      size_(size),
+      length_(0),
+      ready_(false) {}
+
+ParamStatus ParamCache::getParam(const char* name, int* values,
+                                 int length) const {
+  if (!ready_) {
+    return PARAM_PENDING;
+  }
+  int first;
+  if (!find(name, rosserial_msgs::RequestParamsResponse::TYPE_INT, length,
+            &first)) {
+    return PARAM_NOT_FOUND;
+  }
+  ArrayView<Wire<int32_t> > ints = view().ints();
+  for (int i = 0; i < length; i++) {
+    values[i] = ints[first + i];
+  }
+  return PARAM_READY;
+}
+
+ParamStatus ParamCache::getParam(const char* name, float* values,
+                                 int length) const {
+  if (!ready_) {
+    return PARAM_PENDING;
+  }
+  int first;
+  if (!find(name, rosserial_msgs::RequestParamsResponse::TYPE_FLOAT, length,
+            &first)) {
+    return PARAM_NOT_FOUND;
+  }
+  ArrayView<Wire<float> > floats = view().floats();
+  for (int i = 0; i < length; i++) {
+    values[i] = floats[first + i];
+  }
+  return PARAM_READY;
+}
+
+ParamStatus ParamCache::getParam(const char* name, char** values, int length,
+                                 int size) const {
+  if (!ready_) {
+    return PARAM_PENDING;
+  }
+  int first;
+  if (!find(name, rosserial_msgs::RequestParamsResponse::TYPE_STRING, length,
+            &first)) {
+    return PARAM_NOT_FOUND;
+  }
+  SequenceView<StringView> strings = view().strings();
+  for (int i = 0; i < length; i++) {
+    strings[first + i].copyTo(values[i], size);
+  }
+  return PARAM_READY;
+}
+
+bool ParamCache::store(const unsigned char* data, int length) {
+  if (length > size_) {
+    return false;
+  }
+  rosserial_msgs::RequestParamsResponseView reply(data, length);
+  if (reply.wireSize() != length ||
+      reply.types().length() != uint32_t(count_) ||
+      reply.lengths().length() != uint32_t(count_)) {
+    return false;
+  }
+  // Every value the entries claim has to be there.
+  uint32_t totals[4] = {0, 0, 0, 0};
+  for (int i = 0; i < count_; i++) {
+    uint8_t type = reply.types()[i];
+    if (type > rosserial_msgs::RequestParamsResponse::TYPE_STRING) {
+      return false;
+    }
+    totals[type] += reply.lengths()[i];
+  }
+  if (totals[rosserial_msgs::RequestParamsResponse::TYPE_INT] > reply.ints().length() ||
+      totals[rosserial_msgs::RequestParamsResponse::TYPE_FLOAT] > reply.floats().length() ||
+      totals[rosserial_msgs::RequestParamsResponse::TYPE_STRING] > reply.strings().length()) {
+    return false;
+  }
+  memcpy(buffer_, data, length);
+  length_ = length;
+  ready_ = true;
+  return true;
+}
+
+bool ParamCache::find(const char* name, int type, int length,
+                      int* first) const {
+  rosserial_msgs::RequestParamsResponseView reply = view();
+  ArrayView<Wire<uint8_t> > types = reply.types();
+  ArrayView<Wire<uint8_t> > lengths = reply.lengths();
+  *first = 0;
+  for (int i = 0; i < count_; i++) {
+    if (strcmp(names_[i], name) == 0) {
+      return types[i] == type && lengths[i] == length;
+    }
+    if (types[i] == type) {
+      *first += lengths[i];
+    }
+  }
+  return false;
+}
+
+}  // namespace ros
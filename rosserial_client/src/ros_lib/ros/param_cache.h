@@ -0,0 +1,105 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROS_PARAM_CACHE_H_
+#define ROS_PARAM_CACHE_H_
+
+#include "rosserial_msgs/RequestParams.h"
+
+namespace ros {
+
+enum ParamStatus {
+  PARAM_PENDING,  // The host has not answered yet.
+  PARAM_READY,
+  PARAM_NOT_FOUND,  // Not on the host, or not of the requested type and length.
+};
+
+// Parameters fetched from the host in one batch. NodeHandle sends the
+// names once the topics are negotiated and stores the host's reply as is;
+// getParam() reads the values out of it and never blocks, so it can be
+// called from loop() until it stops returning PARAM_PENDING.
+class ParamCache {
+ public:
+  // names must outlive the cache. Replies longer than size bytes are
+  // dropped.
+  ParamCache(const char** names, int count, unsigned char* buffer, int size);
+
+  ParamStatus getParam(const char* name, int* values, int length = 1) const;
+  ParamStatus getParam(const char* name, float* values, int length = 1) const;
+  // Copies each string into a values[i] of size bytes, truncated if need be.
+  ParamStatus getParam(const char* name, char** values, int length,
+                       int size) const;
+
+  bool isReady() const { return ready_; }
+  int getCount() const { return count_; }
+  const char** getNames() const { return names_; }
+
+  // Replaces the cached values with a serialized RequestParamsResponse.
+  // Returns false, keeping the old values, if it is malformed, does not
+  // fit or does not answer every name.
+  bool store(const unsigned char* data, int length);
+
+ private:
+  const char** names_;
+  int count_;
+  unsigned char* buffer_;
+  int size_;
+  int length_;
+  bool ready_;
+
+  // Finds name and the index of its first value among the values of the
+  // same type. Returns false unless it has the given type and length.
+  bool find(const char* name, int type, int length, int* first) const;
+  rosserial_msgs::RequestParamsResponseView view() const {
+    return rosserial_msgs::RequestParamsResponseView(buffer_, length_);
+  }
+
+  ParamCache(const ParamCache&);
+  void operator=(const ParamCache&);
+};
+
+// ParamCache with statically allocated storage for the reply.
+template<int kSize>
+class ParamCacheBuffer : public ParamCache {
+ public:
+  ParamCacheBuffer(const char** names, int count)
+      : ParamCache(names, count, buffer_, kSize) {}
+
+ private:
+  unsigned char buffer_[kSize];
+};
+
+}  // namespace ros
+
+#endif  // ROS_PARAM_CACHE_H_
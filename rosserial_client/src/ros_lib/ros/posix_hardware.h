@@ -0,0 +1,397 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *  notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer in the documentation and/or other materials provided
+ *  with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *  contributors may be used to endorse or promote prducts derived
+ *  from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROS_POSIX_HARDWARE_H_
+#define ROS_POSIX_HARDWARE_H_
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/serial.h>
+#endif
+
+#include "ros/hardware.h"
+#include "ros/msg.h"
+
+namespace ros {
+
+// Runs the client on a POSIX host, typically an embedded Linux
+// co-processor, talking to rosserial over a serial port in raw,
+// non-blocking mode. On Linux the port is also put in low latency mode
+// and, for FTDI adapters, the latency timer is set to 1 ms, which
+// otherwise holds back received bytes for 16 ms. time() and timeMicros()
+// come from CLOCK_MONOTONIC. Like the other backends, BaseT selects
+// run-time or compile-time binding to NodeHandle_.
+//
+// By default spinOnce() reads the port itself. startRxThread() instead
+// starts a thread that waits on the port and fills a single-producer,
+// single-consumer ring of kRxSize bytes, a power of two, so that the
+// application thread never makes a system call to read. Bytes that arrive
+// while the ring is full wait in the kernel.
+//
+//   ros::PosixHardware hardware("/dev/ttyUSB0", 115200);
+//   ros::NodeHandle_<ros::PosixHardware> nh(&hardware);
+//   hardware.init();
+//   hardware.startRxThread();
+template<class BaseT, int kRxSize = 4096>
+class PosixHardware_ : public BaseT {
+ public:
+  PosixHardware_(const char* port = "/dev/ttyUSB0", long baud = 57600)
+      : port_(port), baud_(baud), fd_(-1), rx_head_(0), rx_tail_(0),
+        rx_thread_running_(false), rx_thread_stop_(false) {
+    (void) sizeof(StaticCheck<(kRxSize > 0 && (kRxSize & (kRxSize - 1)) == 0)>);
+    clock_gettime(CLOCK_MONOTONIC, &start_);
+  }
+
+  ~PosixHardware_() {
+    close();
+  }
+
+  // Takes effect on the next init().
+  void setBaud(long baud) {
+    baud_ = baud;
+  }
+
+  int getBaud() const {
+    return baud_;
+  }
+
+  // Opens and configures the port, reopening it if it is open already.
+  // A receive thread that was running is restarted on the reopened port,
+  // so that a baud rate change keeps it. Check isOpen() afterwards; errno
+  // tells why it failed.
+  void init() {
+    bool rx_thread = rx_thread_running_;
+    close();
+    if (openPort() && rx_thread) {
+      startRxThread();
+    }
+  }
+
+  bool isOpen() const {
+    return fd_ >= 0;
+  }
+
+  void close() {
+    stopRxThread();
+    if (fd_ >= 0) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+  }
+
+  // Starts the receive thread. Returns false if the port is not open or
+  // the thread could not be created.
+  bool startRxThread() {
+    if (rx_thread_running_) {
+      return true;
+    }
+    if (fd_ < 0) {
+      return false;
+    }
+    rx_head_ = 0;
+    rx_tail_ = 0;
+    rx_thread_stop_ = false;
+    if (pthread_create(&rx_thread_, NULL, &PosixHardware_::rxThreadMain, this) != 0) {
+      return false;
+    }
+    rx_thread_running_ = true;
+    return true;
+  }
+
+  // Stops the receive thread. Bytes still in the ring are discarded.
+  void stopRxThread() {
+    if (!rx_thread_running_) {
+      return;
+    }
+    store(&rx_thread_stop_, true);
+    pthread_join(rx_thread_, NULL);
+    rx_thread_running_ = false;
+  }
+
+  bool isRxThreadRunning() const {
+    return rx_thread_running_;
+  }
+
+  int read() {
+    uint8_t value;
+    return read(&value, 1) == 1 ? value : -1;
+  }
+
+  int read(uint8_t* buffer, int max) {
+    if (!rx_thread_running_) {
+      if (fd_ < 0) {
+        return 0;
+      }
+      ssize_t count = ::read(fd_, buffer, max);
+      return count < 0 ? 0 : count;
+    }
+    int tail = rx_tail_;
+    int count = (load(&rx_head_) - tail) & (kRxSize - 1);
+    if (count > max) {
+      count = max;
+    }
+    int span = kRxSize - tail;
+    if (span > count) {
+      span = count;
+    }
+    memcpy(buffer, rx_buffer_ + tail, span);
+    memcpy(buffer + span, rx_buffer_, count - span);
+    store(&rx_tail_, (tail + count) & (kRxSize - 1));
+    return count;
+  }
+
+  int available() {
+    if (rx_thread_running_) {
+      return (load(&rx_head_) - rx_tail_) & (kRxSize - 1);
+    }
+    int count = 0;
+#if defined(FIONREAD)
+    if (fd_ >= 0 && ioctl(fd_, FIONREAD, &count) < 0) {
+      count = 0;
+    }
+#endif
+    return count;
+  }
+
+  // Waits for the port to take all of data, as NodeOutput expects.
+  void write(uint8_t* data, int length) {
+    while (length > 0 && fd_ >= 0) {
+      ssize_t count = ::write(fd_, data, length);
+      if (count < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+          return;
+        }
+        struct pollfd output = { fd_, POLLOUT, 0 };
+        poll(&output, 1, kPollTimeoutMs);
+        continue;
+      }
+      data += count;
+      length -= count;
+    }
+  }
+
+  unsigned long time() const {
+    return elapsedMicros() / 1000;
+  }
+
+  unsigned long timeMicros() const {
+    return elapsedMicros();
+  }
+
+  int getFd() const {
+    return fd_;
+  }
+
+ private:
+  // How long the receive thread waits for input before checking whether
+  // it should stop, and write() for the port to drain.
+  static const int kPollTimeoutMs = 50;
+
+  const char* port_;
+  long baud_;
+  int fd_;
+  struct timespec start_;
+  uint8_t rx_buffer_[kRxSize];
+  // rx_head_ is only written by the receive thread, rx_tail_ only by the
+  // reader.
+  volatile int rx_head_;
+  volatile int rx_tail_;
+  pthread_t rx_thread_;
+  bool rx_thread_running_;
+  volatile bool rx_thread_stop_;
+
+  unsigned long long elapsedMicros() const {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long) (now.tv_sec - start_.tv_sec) * 1000000ull +
+           (now.tv_nsec - start_.tv_nsec) / 1000;
+  }
+
+  // The barriers order the ring's data accesses around the index updates.
+  template<typename T>
+  static T load(volatile T* value) {
+    T result = *value;
+    __sync_synchronize();
+    return result;
+  }
+
+  template<typename T>
+  static void store(volatile T* target, T value) {
+    __sync_synchronize();
+    *target = value;
+  }
+
+  static void* rxThreadMain(void* hardware) {
+    static_cast<PosixHardware_*>(hardware)->rxLoop();
+    return NULL;
+  }
+
+  void rxLoop() {
+    while (!load(&rx_thread_stop_)) {
+      int head = rx_head_;
+      // One slot stays empty to tell a full ring from an empty one.
+      int space = (load(&rx_tail_) - head - 1) & (kRxSize - 1);
+      if (space == 0) {
+        usleep(1000);
+        continue;
+      }
+      struct pollfd input = { fd_, POLLIN, 0 };
+      if (poll(&input, 1, kPollTimeoutMs) <= 0) {
+        continue;
+      }
+      int span = kRxSize - head;
+      if (span > space) {
+        span = space;
+      }
+      ssize_t count = ::read(fd_, rx_buffer_ + head, span);
+      if (count > 0) {
+        store(&rx_head_, (int) ((head + count) & (kRxSize - 1)));
+      } else if (count == 0 || (errno != EAGAIN && errno != EINTR)) {
+        // The device went away; don't spin on it.
+        usleep(kPollTimeoutMs * 1000);
+      }
+    }
+  }
+
+  // Opens and configures the closed port.
+  bool openPort() {
+    speed_t speed = baudToSpeed(baud_);
+    if (speed == 0) {
+      errno = EINVAL;
+      return false;
+    }
+    fd_ = ::open(port_, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd_ < 0) {
+      return false;
+    }
+    struct termios tio;
+    if (tcgetattr(fd_, &tio) < 0) {
+      close();
+      return false;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    if (cfsetispeed(&tio, speed) < 0 || cfsetospeed(&tio, speed) < 0 ||
+        tcsetattr(fd_, TCSANOW, &tio) < 0) {
+      int error = errno;
+      close();
+      errno = error;
+      return false;
+    }
+    setLowLatency();
+    tcflush(fd_, TCIOFLUSH);
+    return true;
+  }
+
+  void setLowLatency() {
+#if defined(__linux__)
+    struct serial_struct serial;
+    if (ioctl(fd_, TIOCGSERIAL, &serial) == 0) {
+      serial.flags |= ASYNC_LOW_LATENCY;
+      // Not all drivers support it, which is fine.
+      ioctl(fd_, TIOCSSERIAL, &serial);
+    }
+    char device[PATH_MAX];
+    if (realpath(port_, device) == NULL) {
+      return;
+    }
+    const char* name = strrchr(device, '/');
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "/sys/bus/usb-serial/devices/%s/latency_timer",
+             name == NULL ? device : name + 1);
+    FILE* latency_timer = fopen(path, "w");
+    if (latency_timer != NULL) {
+      fputs("1", latency_timer);
+      fclose(latency_timer);
+    }
+#endif
+  }
+
+  static speed_t baudToSpeed(long baud) {
+    switch (baud) {
+      case 9600: return B9600;
+      case 19200: return B19200;
+      case 38400: return B38400;
+      case 57600: return B57600;
+      case 115200: return B115200;
+      case 230400: return B230400;
+#ifdef B460800
+      case 460800: return B460800;
+#endif
+#ifdef B500000
+      case 500000: return B500000;
+#endif
+#ifdef B921600
+      case 921600: return B921600;
+#endif
+#ifdef B1000000
+      case 1000000: return B1000000;
+#endif
+#ifdef B1500000
+      case 1500000: return B1500000;
+#endif
+#ifdef B2000000
+      case 2000000: return B2000000;
+#endif
+#ifdef B3000000
+      case 3000000: return B3000000;
+#endif
+      default: return 0;
+    }
+  }
+
+  PosixHardware_(const PosixHardware_&);
+  void operator=(const PosixHardware_&);
+};
+
+typedef PosixHardware_<Hardware> PosixHardware;
+typedef PosixHardware_<StaticHardware> StaticPosixHardware;
+
+}  // namespace ros
+
+#endif  // ROS_POSIX_HARDWARE_H_
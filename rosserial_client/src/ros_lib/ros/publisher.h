@@ -35,7 +35,10 @@
 #ifndef PUBLISHER_H_
 #define PUBLISHER_H_
 
+#include "delta_encoding.h"
+#include "link_statistics.h"
 #include "node_output.h"
+#include "rosserial_msgs/TopicInfo.h"
 
 namespace ros {
 
@@ -46,15 +49,21 @@ namespace ros {
 
       virtual ~Publisher() {}
 
-      int publish(Msg* msg) {
-        return node_output_->publish(id_, msg_);
+      // Virtual so that publishers that send differently can't be
+      // bypassed through a reference to this class.
+      virtual int publish(Msg* msg) {
+        int length = node_output_->publish(id_, msg);
+#if ROSSERIAL_DIAGNOSTICS
+        counters_.count(length);
+#endif
+        return length;
       }
 
       void setId(int id) { id_ = id; }
 
       int getId() { return id_; }
 
-      void setNodeOutput(NodeOutput* node_output) {
+      void setNodeOutput(NodeOutputBase* node_output) {
         node_output_ = node_output;
       }
 
@@ -66,16 +75,157 @@ namespace ros {
         return msg_->getType();
       }
 
-    private:
+      // How samples are encoded on the wire, listed to the host.
+      virtual uint8_t getEncoding() {
+        return rosserial_msgs::TopicInfo::ENCODING_NONE;
+      }
+
+#if ROSSERIAL_DIAGNOSTICS
+      const TopicCounters& getCounters() { return counters_; }
+#endif
+
+    protected:
       const char* topic_name_;
       Msg* msg_;
       int id_;
-      NodeOutput* node_output_;
+      NodeOutputBase* node_output_;
+#if ROSSERIAL_DIAGNOSTICS
+      TopicCounters counters_;
+#endif
 
+    private:
       Publisher(const Publisher&);
       void operator=(const Publisher&);
   };
 
+  /* Publisher that only keeps the newest sample
+   * publish() marks the message as updated instead of sending it. The
+   * node handle serializes the message's current contents once the link
+   * has room for it, at most once every min_period milliseconds. Samples
+   * published in between replace each other rather than queueing up.
+   */
+  class CoalescingPublisher : public Publisher {
+    public:
+      CoalescingPublisher(const char* topic_name, Msg* msg,
+                          unsigned long min_period = 0)
+          : Publisher(topic_name, msg), pending_(false),
+            min_period_(min_period), last_sent_(0), next_(0) {}
+
+      // msg must be the message given to the constructor, since it is read
+      // when the sample is eventually sent.
+      virtual int publish(Msg* msg) {
+        if (msg != msg_) {
+          return -1;
+        }
+        pending_ = true;
+        return 0;
+      }
+
+      bool isPending() { return pending_; }
+
+      // Called by the node handle. Sends the pending sample if the rate
+      // limit allows it and room, the bytes the link can take (-1 if
+      // unknown), is enough for the frame. A frame bigger than capacity,
+      // the most room the link has had, waits until the link has that
+      // much. It is then written the blocking way, or dropped if it can't
+      // be queued.
+      bool trySend(unsigned long now, int room, int capacity) {
+        if (!pending_ || now - last_sent_ < min_period_) {
+          return false;
+        }
+        int needed = msg_->serializedLength() + NodeOutputBase::kFrameOverhead;
+        if (room >= 0 && room < (needed < capacity ? needed : capacity)) {
+          return false;
+        }
+        int length = node_output_->publish(id_, msg_);
+#if ROSSERIAL_DIAGNOSTICS
+        counters_.count(length);
+#endif
+        if (length < 0) {
+          if (room >= 0 && needed > capacity) {
+            // It will never fit; retrying would starve the other topics.
+            pending_ = false;
+            last_sent_ = now;
+          }
+          return false;
+        }
+        pending_ = false;
+        last_sent_ = now;
+        return true;
+      }
+
+      // The node handle keeps its coalescing publishers in a list.
+      void setNext(CoalescingPublisher* next) { next_ = next; }
+      CoalescingPublisher* getNext() { return next_; }
+
+    private:
+      bool pending_;
+      unsigned long min_period_;
+      unsigned long last_sent_;
+      CoalescingPublisher* next_;
+  };
+
+  /* Publisher that sends most samples as the difference to the one before
+   * (see DeltaFrame), which for messages that change little between
+   * samples, like scans, joint states or headers with the same frame_id,
+   * is a fraction of their size. A sample is sent whole when its length
+   * changed, when the delta would not be smaller, and once every
+   * keyframe_interval samples so that a host that lost a frame catches
+   * up. Messages must serialize to at most Size bytes; two buffers of
+   * that size are kept. Needs a host that understands ENCODING_DELTA.
+   */
+  template<int Size>
+  class DeltaPublisher : public Publisher {
+    public:
+      DeltaPublisher(const char* topic_name, Msg* msg, int keyframe_interval = 10)
+          : Publisher(topic_name, msg), keyframe_interval_(keyframe_interval),
+            since_keyframe_(0), sequence_(0), sample_(buffers_[0]),
+            previous_(buffers_[1]), previous_length_(-1) {}
+
+      virtual int publish(Msg* msg) {
+        int length = msg->serialize(sample_, Size);
+        if (length < 0) {
+          return -1;
+        }
+        bool keyframe = length != previous_length_ ||
+                        since_keyframe_ + 1 >= keyframe_interval_;
+        DeltaFrame frame(sequence_, sample_, keyframe ? 0 : previous_, length);
+        if (!keyframe && frame.serializedLength() >= DeltaFrame::kHeaderSize + length) {
+          keyframe = true;
+          frame = DeltaFrame(sequence_, sample_, 0, length);
+        }
+        int sent = node_output_->publish(id_, &frame);
+#if ROSSERIAL_DIAGNOSTICS
+        counters_.count(sent);
+#endif
+        if (sent < 0) {
+          // The host still has the previous sample to apply deltas to.
+          return -1;
+        }
+        unsigned char* sample = sample_;
+        sample_ = previous_;
+        previous_ = sample;
+        previous_length_ = length;
+        since_keyframe_ = keyframe ? 0 : since_keyframe_ + 1;
+        sequence_++;
+        return sent;
+      }
+
+      virtual uint8_t getEncoding() {
+        return rosserial_msgs::TopicInfo::ENCODING_DELTA;
+      }
+
+    private:
+      int keyframe_interval_;
+      int since_keyframe_;
+      unsigned char sequence_;
+      unsigned char buffers_[2][Size];
+      // The sample being sent, and the one sent before it.
+      unsigned char* sample_;
+      unsigned char* previous_;
+      int previous_length_;
+  };
+
 }  // namespace ros
 
 #endif
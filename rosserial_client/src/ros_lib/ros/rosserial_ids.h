@@ -39,5 +39,10 @@
 #define TOPIC_PUBLISHERS    0
 #define TOPIC_SUBSCRIBERS   1
 #define TOPIC_SERVICES      2
+#define TOPIC_SERVICE_CLIENTS 3
+// Several (topic, length, payload) records under one header and checksum.
+#define TOPIC_BATCH         6
+// rosserial_msgs/LinkStatistics, sent with ROSSERIAL_DIAGNOSTICS.
+#define TOPIC_DIAGNOSTICS   9
 
 #endif
@@ -0,0 +1,98 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ros/rx_queue.h"
+
+#include <string.h>
+
+namespace ros {
+
+RxQueue::RxQueue(unsigned char* buffer, int size)
+    : buffer_(buffer),
+      size_(size),
+      length_(0),
+      front_(-1),
+      high_water_mark_(0),
+      dropped_frame_count_(0) {}
+
+bool RxQueue::push(int topic, int priority, const unsigned char* data, int length) {
+  if (kRecordHeaderSize + length > size_ - length_) {
+    ++dropped_frame_count_;
+    return false;
+  }
+  unsigned char* record = buffer_ + length_;
+  record[0] = priority;
+  record[1] = topic & 0xff;
+  record[2] = topic >> 8;
+  record[3] = length & 0xff;
+  record[4] = length >> 8;
+  memcpy(record + kRecordHeaderSize, data, length);
+  length_ += kRecordHeaderSize + length;
+  if (length_ > high_water_mark_) {
+    high_water_mark_ = length_;
+  }
+  return true;
+}
+
+bool RxQueue::front(int* topic, unsigned char** data, int* length) {
+  front_ = -1;
+  // Queues are small, so a scan is cheaper than keeping them sorted.
+  for (int offset = 0; offset < length_;
+       offset += kRecordHeaderSize + (buffer_[offset + 3] | (buffer_[offset + 4] << 8))) {
+    if (front_ < 0 || buffer_[offset] > buffer_[front_]) {
+      front_ = offset;
+    }
+  }
+  if (front_ < 0) {
+    return false;
+  }
+  unsigned char* record = buffer_ + front_;
+  *topic = record[1] | (record[2] << 8);
+  *length = record[3] | (record[4] << 8);
+  *data = record + kRecordHeaderSize;
+  return true;
+}
+
+void RxQueue::pop() {
+  if (front_ < 0) {
+    return;
+  }
+  unsigned char* record = buffer_ + front_;
+  int size = kRecordHeaderSize + (record[3] | (record[4] << 8));
+  memmove(record, record + size, length_ - front_ - size);
+  length_ -= size;
+  front_ = -1;
+}
+
+}  // namespace ros
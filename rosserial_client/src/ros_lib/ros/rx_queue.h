@@ -0,0 +1,90 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROS_RX_QUEUE_H_
+#define ROS_RX_QUEUE_H_
+
+namespace ros {
+
+// Received frames whose callbacks NodeHandle::spinFor() defers. Frames
+// are kept back to back in arrival order, each as
+//   [priority][topic low][topic high][length low][length high][payload]
+// so that a callback gets its payload in one piece. They are taken out
+// highest priority first, and oldest first among equal priorities.
+class RxQueue {
+ public:
+  RxQueue(unsigned char* buffer, int size);
+
+  // Queues the payload of a frame for topic. Returns false and counts a
+  // dropped frame if it does not fit.
+  bool push(int topic, int priority, const unsigned char* data, int length);
+  // Finds the frame to dispatch next. Returns false if the queue is empty.
+  bool front(int* topic, unsigned char** data, int* length);
+  // Removes the frame found by front().
+  void pop();
+
+  bool empty() const { return length_ == 0; }
+  // Number of bytes queued.
+  int getDepth() const { return length_; }
+  int getHighWaterMark() const { return high_water_mark_; }
+  int getDroppedFrameCount() const { return dropped_frame_count_; }
+
+ private:
+  static const int kRecordHeaderSize = 5;
+
+  unsigned char* buffer_;
+  int size_;
+  int length_;
+  // Offset of the record found by front(), or -1.
+  int front_;
+  int high_water_mark_;
+  int dropped_frame_count_;
+
+  RxQueue(const RxQueue&);
+  void operator=(const RxQueue&);
+};
+
+// RxQueue with statically allocated storage.
+template<int kSize>
+class RxQueueBuffer : public RxQueue {
+ public:
+  RxQueueBuffer() : RxQueue(buffer_, kSize) {}
+
+ private:
+  unsigned char buffer_[kSize];
+};
+
+}  // namespace ros
+
+#endif  // ROS_RX_QUEUE_H_
@@ -0,0 +1,124 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *  notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer in the documentation and/or other materials provided
+ *  with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *  contributors may be used to endorse or promote prducts derived
+ *  from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROS_SERVICE_CLIENT_H_
+#define ROS_SERVICE_CLIENT_H_
+
+#include "msg_receiver.h"
+#include "node_output.h"
+#include "rosserial_ids.h"
+#include "service_frame.h"
+
+namespace ros {
+
+  /* ROS Service Client
+   * Calls a service on the host without blocking. call() sends the
+   * request and returns its ID at once; spinOnce() later hands the
+   * response to the callback together with that ID, so several calls can
+   * be outstanding. Calls still outstanding when the connection is lost
+   * are never answered, callers that care keep their own timeouts.
+   */
+  template<typename SrvRequest, typename SrvResponse>
+  class ServiceClient : MsgReceiver {
+    public:
+      using MsgReceiver::setPriority;
+
+      // success is false if the host could not complete the call, response
+      // is then not valid.
+      typedef void(*CallbackT)(int request_id, bool success, const SrvResponse& response);
+
+      ServiceClient(const char* topic_name, CallbackT callback)
+          : callback_(callback), node_output_(0), next_request_id_(0) {
+        topic_name_ = topic_name;
+      }
+
+      virtual ~ServiceClient() {}
+
+      // Returns the ID the response will carry, or -1 if the request could
+      // not be sent.
+      int call(SrvRequest& request) {
+        if (node_output_ == 0) {
+          return -1;
+        }
+        uint16_t request_id = next_request_id_;
+        ServiceFrame frame = ServiceFrame::request(request_id, &request);
+        if (node_output_->publish(id_, &frame) < 0) {
+          return -1;
+        }
+        next_request_id_++;
+        return request_id;
+      }
+
+      virtual bool receive(unsigned char* data, int limit) {
+        if (limit < ServiceFrame::kResponseHeaderSize) {
+          return false;
+        }
+        uint16_t request_id = ServiceFrame::requestId(data);
+        bool success = data[2] != 0;
+        bool valid = true;
+        if (success) {
+          int length = limit - ServiceFrame::kResponseHeaderSize;
+          valid = response_.deserialize(data + ServiceFrame::kResponseHeaderSize,
+                                        length) == length;
+        }
+        // A response that fails to deserialize still completes its call.
+        callback_(request_id, success && valid, response_);
+        return valid;
+      }
+
+      virtual const char* getMessageType() {
+        return response_.getType();
+      }
+
+      virtual int getTopicType() {
+        return TOPIC_SERVICE_CLIENTS;
+      }
+
+      void setNodeOutput(NodeOutputBase* node_output) {
+        node_output_ = node_output;
+      }
+
+    private:
+      SrvResponse response_;
+      CallbackT callback_;
+      NodeOutputBase* node_output_;
+      uint16_t next_request_id_;
+
+      ServiceClient(const ServiceClient&);
+      void operator=(const ServiceClient&);
+  };
+
+}  // namespace ros
+
+#endif
@@ -0,0 +1,115 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *  notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *  copyright notice, this list of conditions and the following
+ *  disclaimer in the documentation and/or other materials provided
+ *  with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *  contributors may be used to endorse or promote prducts derived
+ *  from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROS_SERVICE_FRAME_H_
+#define ROS_SERVICE_FRAME_H_
+
+#include <stdint.h>
+
+#include "msg.h"
+
+namespace ros {
+
+  /* Service calls travel on the ID of the service in both directions, so
+   * that several can be in flight at once. A request is the 16 bit ID of
+   * the call followed by the serialized request,
+   *   [request_id][request]
+   * and the matching response echoes the ID, followed by a status byte
+   * and, if the call succeeded, the serialized response.
+   *   [request_id][success][response]
+   */
+  class ServiceFrame : public Msg {
+    public:
+      static const int kRequestHeaderSize = 2;
+      static const int kResponseHeaderSize = 3;
+
+      // A request with the given ID.
+      static ServiceFrame request(uint16_t request_id, Msg* request) {
+        return ServiceFrame(request_id, kRequestHeaderSize, true, request);
+      }
+
+      // A response to the request with the given ID. body is only sent if
+      // success is true.
+      static ServiceFrame response(uint16_t request_id, bool success, Msg* body) {
+        return ServiceFrame(request_id, kResponseHeaderSize, success, body);
+      }
+
+      static uint16_t requestId(const unsigned char* data) {
+        return data[0] | (data[1] << 8);
+      }
+
+      virtual int serialize(unsigned char* buffer, int limit) {
+        if (limit < header_size_) {
+          return -1;
+        }
+        buffer[0] = request_id_ & 0xff;
+        buffer[1] = request_id_ >> 8;
+        if (header_size_ == kResponseHeaderSize) {
+          buffer[2] = success_ ? 1 : 0;
+        }
+        if (!success_) {
+          return header_size_;
+        }
+        int length = body_->serialize(buffer + header_size_, limit - header_size_);
+        return length < 0 ? -1 : header_size_ + length;
+      }
+
+      // Frames are only built for sending; receivers parse the header
+      // themselves and deserialize the body in place.
+      virtual int deserialize(unsigned char*, int) {
+        return -1;
+      }
+
+      virtual int serializedLength() {
+        return header_size_ + (success_ ? body_->serializedLength() : 0);
+      }
+
+      virtual const char* getType() {
+        return body_->getType();
+      }
+
+    private:
+      uint16_t request_id_;
+      int header_size_;
+      bool success_;
+      Msg* body_;
+
+      ServiceFrame(uint16_t request_id, int header_size, bool success, Msg* body)
+          : request_id_(request_id), header_size_(header_size),
+            success_(success), body_(body) {}
+  };
+
+}  // namespace ros
+
+#endif
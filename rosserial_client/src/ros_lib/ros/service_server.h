@@ -35,38 +35,67 @@
 #ifndef ROS_SERVICE_SERVER_H_
 #define ROS_SERVICE_SERVER_H_
 
+#include "msg_receiver.h"
 #include "node_output.h"
+#include "rosserial_ids.h"
+#include "service_frame.h"
 
 namespace ros {
 
+  /* ROS Service Server
+   * Answers calls from the host. Each request is answered with the ID it
+   * arrived with, so the host may have several calls outstanding; a
+   * request that fails to deserialize is answered with a failed response
+   * instead of going unanswered.
+   */
   template<typename SrvRequest, typename SrvResponse>
   class ServiceServer : MsgReceiver {
     public:
+      using MsgReceiver::setPriority;
+
       typedef void(*CallbackT)(const SrvRequest&, SrvResponse&);
 
-      ServiceServer(const char* topic_name, CallbackT callback) {
+      ServiceServer(const char* topic_name, CallbackT callback)
+          : callback_(callback), node_output_(0) {
         topic_name_ = topic_name;
-        callback_ = callback;
       }
 
       virtual ~ServiceServer() {}
 
-      virtual void receive(unsigned char* data) {
-        req.deserialize(data);
-        callback_(req, resp);
-        node_ouput_->publish(id_, &resp);
+      virtual bool receive(unsigned char* data, int limit) {
+        if (limit < ServiceFrame::kRequestHeaderSize) {
+          return false;
+        }
+        uint16_t request_id = ServiceFrame::requestId(data);
+        int length = limit - ServiceFrame::kRequestHeaderSize;
+        bool success =
+            req.deserialize(data + ServiceFrame::kRequestHeaderSize, length) == length;
+        if (success) {
+          callback_(req, resp);
+        }
+        ServiceFrame response = ServiceFrame::response(request_id, success, &resp);
+        node_output_->publish(id_, &response);
+        return success;
       }
 
       virtual const char* getMessageType() {
         return req.getType();
       }
 
+      virtual int getTopicType() {
+        return TOPIC_SERVICES;
+      }
+
+      void setNodeOutput(NodeOutputBase* node_output) {
+        node_output_ = node_output;
+      }
+
       SrvRequest req;
       SrvResponse resp;
 
     private:
       CallbackT callback_;
-      NodeOutput* node_ouput_;
+      NodeOutputBase* node_output_;
 
       ServiceServer(const ServiceServer&);
       void operator=(const ServiceServer&);
@@ -48,6 +48,8 @@ namespace ros {
   template<typename MsgType>
   class Subscriber : MsgReceiver {
     public:
+      using MsgReceiver::setPriority;
+
       typedef void(*CallbackT)(const MsgType&);
 
       Subscriber(const char* topic_name, CallbackT callback) {
@@ -77,6 +79,46 @@ namespace ros {
       void operator=(const Subscriber&);
   };
 
+  /* ROS Subscriber for read-only message views
+   * The callback gets a MsgType::View that decodes fields on access
+   * straight from the received frame, so nothing is deserialized or
+   * copied. The view is only valid during the callback.
+   */
+  template<typename MsgType>
+  class ViewSubscriber : MsgReceiver {
+    public:
+      using MsgReceiver::setPriority;
+
+      typedef typename MsgType::View ViewT;
+      typedef void(*CallbackT)(const ViewT&);
+
+      ViewSubscriber(const char* topic_name, CallbackT callback) {
+        topic_name_ = topic_name;
+        callback_ = callback;
+      }
+
+      virtual ~ViewSubscriber() {}
+
+      virtual bool receive(unsigned char* data, int limit) {
+        ViewT view(data, limit);
+        bool success = view.wireSize() == limit;
+        if (success) {
+          callback_(view);
+        }
+        return success;
+      }
+
+      virtual const char* getMessageType() {
+        return ViewT::getType();
+      }
+
+    private:
+      CallbackT callback_;
+
+      ViewSubscriber(const ViewSubscriber&);
+      void operator=(const ViewSubscriber&);
+  };
+
 }  // namespace ros
 
 #endif
@@ -35,7 +35,6 @@
 #include "ros/time.h"
 
 #include <limits.h>
-#include <math.h>
 
 namespace ros {
 
@@ -50,8 +49,10 @@ float Time::toSec() const {
 }
 
 Time Time::fromSec(float seconds) {
-  unsigned long sec = floor(seconds);
-  unsigned long nsec = round((seconds - sec) * 1e9f);
+  // seconds is nonnegative, so the casts floor and round it without the
+  // library calls.
+  unsigned long sec = static_cast<unsigned long>(seconds);
+  unsigned long nsec = static_cast<unsigned long>((seconds - sec) * 1e9f + 0.5f);
   return Time(sec, nsec);
 }
 
@@ -91,9 +92,17 @@ Duration Time::operator-(const Time &rhs) const {
 }
 
 void Time::normalize() {
-  unsigned long sec_part = nsec / 1000000000ul;
-  nsec %= 1000000000ul;
-  sec += sec_part;
+  // The operators leave nsec below two seconds, so one conditional
+  // subtraction is enough. Only out of range constructor arguments take
+  // the divide.
+  if (nsec >= 1000000000ul) {
+    nsec -= 1000000000ul;
+    ++sec;
+    if (nsec >= 1000000000ul) {
+      sec += nsec / 1000000000ul;
+      nsec %= 1000000000ul;
+    }
+  }
 }
 
 }  // namespace ros
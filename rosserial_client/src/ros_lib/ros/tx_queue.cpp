@@ -0,0 +1,145 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ros/tx_queue.h"
+
+#include <string.h>
+
+namespace ros {
+
+bool FrameRing::push(const unsigned char* data, int length) {
+  if (length > space()) {
+    return false;
+  }
+  int tail = head_ + count_;
+  if (tail >= size_) {
+    tail -= size_;
+  }
+  int first = size_ - tail;
+  if (first > length) {
+    first = length;
+  }
+  memcpy(buffer_ + tail, data, first);
+  memcpy(buffer_, data + first, length - first);
+  count_ += length;
+  return true;
+}
+
+unsigned char FrameRing::peek(int index) const {
+  index += head_;
+  if (index >= size_) {
+    index -= size_;
+  }
+  return buffer_[index];
+}
+
+const unsigned char* FrameRing::front(int* span) const {
+  *span = size_ - head_;
+  if (*span > count_) {
+    *span = count_;
+  }
+  return buffer_ + head_;
+}
+
+void FrameRing::pop(int length) {
+  head_ += length;
+  if (head_ >= size_) {
+    head_ -= size_;
+  }
+  count_ -= length;
+}
+
+TxQueue::TxQueue(unsigned char* buffer, int size,
+                 unsigned char* priority_buffer, int priority_size)
+    : bulk_(buffer, size),
+      priority_(priority_buffer, priority_size),
+      current_(0),
+      frame_remaining_(0),
+      high_water_mark_(0),
+      dropped_frame_count_(0) {}
+
+bool TxQueue::enqueue(const unsigned char* frame, int length, bool priority) {
+  FrameRing& ring = priority ? priority_ : bulk_;
+  if (!ring.push(frame, length)) {
+    ++dropped_frame_count_;
+    return false;
+  }
+  if (getDepth() > high_water_mark_) {
+    high_water_mark_ = getDepth();
+  }
+  return true;
+}
+
+bool TxQueue::startFrame() {
+  if (priority_.count() > 0) {
+    current_ = &priority_;
+  } else if (bulk_.count() > 0) {
+    current_ = &bulk_;
+  } else {
+    return false;
+  }
+  // 6 header bytes, the data length and 1 checksum byte.
+  frame_remaining_ = 7 + current_->peek(4) + (current_->peek(5) << 8);
+  return true;
+}
+
+void TxQueue::finishSpan(int span) {
+  current_->pop(span);
+  frame_remaining_ -= span;
+  if (frame_remaining_ == 0) {
+    current_ = 0;
+  }
+}
+
+bool TxQueue::empty() const {
+  return getDepth() == 0;
+}
+
+int TxQueue::getDepth() const {
+  return bulk_.count() + priority_.count();
+}
+
+int TxQueue::getSpace() const {
+  return bulk_.space();
+}
+
+int TxQueue::getHighWaterMark() const {
+  return high_water_mark_;
+}
+
+int TxQueue::getDroppedFrameCount() const {
+  return dropped_frame_count_;
+}
+
+}  // namespace ros
@@ -0,0 +1,145 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROS_TX_QUEUE_H_
+#define ROS_TX_QUEUE_H_
+
+namespace ros {
+
+// Ring buffer of complete, framed packets.
+class FrameRing {
+ public:
+  FrameRing(unsigned char* buffer, int size)
+      : buffer_(buffer), size_(size), head_(0), count_(0) {}
+
+  // Number of bytes queued.
+  int count() const { return count_; }
+  int space() const { return size_ - count_; }
+
+  // Appends length bytes. Nothing is queued if they do not all fit.
+  bool push(const unsigned char* data, int length);
+  // Returns the byte index bytes past the oldest queued byte.
+  unsigned char peek(int index) const;
+  // Returns the oldest queued bytes and sets span to how many of them are
+  // contiguous in memory.
+  const unsigned char* front(int* span) const;
+  void pop(int length);
+
+ private:
+  unsigned char* buffer_;
+  int size_;
+  int head_;
+  int count_;
+
+  FrameRing(const FrameRing&);
+  void operator=(const FrameRing&);
+};
+
+// Transmit queue for NodeOutput. Frames are queued by publish() and written
+// out by drain() as the hardware can take them. Frames queued with priority
+// (time sync, logging, negotiation) are sent before bulk topic data, but a
+// frame that has been partially written is always finished first.
+class TxQueue {
+ public:
+  TxQueue(unsigned char* buffer, int size,
+          unsigned char* priority_buffer, int priority_size);
+
+  // Queues a complete frame. Returns false and counts a dropped frame if it
+  // does not fit.
+  bool enqueue(const unsigned char* frame, int length, bool priority);
+  // Writes queued frames until the queue is empty or the hardware would
+  // block.
+  template<class HardwareT>
+  void drain(HardwareT* hardware) {
+    int writable = hardware->availableForWrite();
+    while (writable != 0) {
+      if (current_ == 0 && !startFrame()) {
+        return;
+      }
+      int span;
+      unsigned char* data = const_cast<unsigned char*>(current_->front(&span));
+      if (span > frame_remaining_) {
+        span = frame_remaining_;
+      }
+      if (writable > 0 && span > writable) {
+        span = writable;
+      }
+      hardware->write(data, span);
+      finishSpan(span);
+      if (writable > 0) {
+        writable -= span;
+      }
+    }
+  }
+
+  bool empty() const;
+  // Number of bytes queued.
+  int getDepth() const;
+  // Bytes free for frames queued without priority.
+  int getSpace() const;
+  int getHighWaterMark() const;
+  int getDroppedFrameCount() const;
+
+ private:
+  FrameRing bulk_;
+  FrameRing priority_;
+  // Ring whose oldest frame is being written, or 0 between frames.
+  FrameRing* current_;
+  int frame_remaining_;
+  int high_water_mark_;
+  int dropped_frame_count_;
+
+  // Picks the ring to send the next frame from. Returns false if both are
+  // empty.
+  bool startFrame();
+  void finishSpan(int span);
+
+  TxQueue(const TxQueue&);
+  void operator=(const TxQueue&);
+};
+
+// TxQueue with statically allocated storage.
+template<int kSize, int kPrioritySize = 64>
+class TxQueueBuffer : public TxQueue {
+ public:
+  TxQueueBuffer() : TxQueue(buffer_, kSize, priority_buffer_, kPrioritySize) {}
+
+ private:
+  unsigned char buffer_[kSize];
+  unsigned char priority_buffer_[kPrioritySize];
+};
+
+}  // namespace ros
+
+#endif  // ROS_TX_QUEUE_H_
@@ -0,0 +1,322 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROS_XBEE_HARDWARE_H_
+#define ROS_XBEE_HARDWARE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include "ros/hardware.h"
+
+namespace ros {
+
+// Carries the rosserial stream over a Series 1 (802.15.4) XBee in API mode
+// with escaping (AP=2), the mode rosserial_xbee's xbee_network.py runs the
+// coordinator in. LinkT is the backend of the serial port the XBee is wired
+// to, e.g. StaticArduinoHardware. Like for the other backends, BaseT
+// selects run-time or compile-time binding to NodeHandle_.
+//
+// Outgoing frames are packed into RF packets of up to kMtu bytes. A frame
+// that fits in a packet never straddles two, so the host can drop a
+// damaged packet and pick up again at the next one. A packet is sent when
+// the next frame would not fit, or once its first byte has waited
+// flush_delay milliseconds; the wait is checked on every read() by
+// spinOnce(). Frames longer than kMtu are sent in several packets.
+// Incoming RF packets are only accepted from host_address.
+//
+//   StaticArduinoHardware serial(&Serial, 57600);
+//   ros::XBeeHardware<StaticArduinoHardware> xbee(&serial);
+//   ros::NodeHandle_<ros::XBeeHardware<StaticArduinoHardware> > nh(&xbee);
+template<class LinkT, class BaseT = StaticHardware>
+class XBeeHardware : public BaseT {
+ public:
+  // Largest RF payload of a Series 1 XBee.
+  enum { kMtu = 100 };
+
+  XBeeHardware(LinkT* link, uint16_t host_address = 0, unsigned long flush_delay = 5)
+      : link_(link), host_address_(host_address), flush_delay_(flush_delay),
+        tx_length_(0), tx_time_(0), header_length_(0), frame_remaining_(0),
+        rx_state_(kIdle), rx_length_(0), rx_count_(0), rx_checksum_(0),
+        rx_escape_(false), rx_data_(0), rx_remaining_(0) {}
+
+  void setBaud(long baud) {
+    link_->setBaud(baud);
+  }
+
+  int getBaud() const {
+    return link_->getBaud();
+  }
+
+  void init() {
+    link_->init();
+  }
+
+  int read() {
+    uint8_t input_byte;
+    return read(&input_byte, 1) == 1 ? input_byte : -1;
+  }
+
+  int read(uint8_t* buffer, int max) {
+    if (tx_length_ > 0 && link_->time() - tx_time_ >= flush_delay_) {
+      flush();
+    }
+    int count = 0;
+    while (count < max && (rx_remaining_ > 0 || receivePacket())) {
+      int span = max - count < rx_remaining_ ? max - count : rx_remaining_;
+      memcpy(buffer + count, rx_data_, span);
+      rx_data_ += span;
+      rx_remaining_ -= span;
+      count += span;
+    }
+    return count;
+  }
+
+  int available() {
+    return rx_remaining_;
+  }
+
+  void write(uint8_t* data, int length) {
+    for (int i = 0; i < length; i++) {
+      if (frame_remaining_ > 0) {
+        append(data[i]);
+        frame_remaining_--;
+        if (frame_remaining_ == 0) {
+          finishFrame();
+        }
+        continue;
+      }
+      // Hold back the header of the next frame until its length is known.
+      header_[header_length_++] = data[i];
+      if (header_length_ < kHeaderSize) {
+        continue;
+      }
+      header_length_ = 0;
+      int frame_length = kHeaderSize;
+      if (header_[0] == 0xff && header_[1] == 0xff) {
+        frame_length += (header_[4] | (header_[5] << 8)) + 1;
+      }
+      if (tx_length_ > 0 && tx_length_ + frame_length > kMtu) {
+        flush();
+      }
+      for (int j = 0; j < kHeaderSize; j++) {
+        append(header_[j]);
+      }
+      frame_remaining_ = frame_length - kHeaderSize;
+      if (frame_remaining_ == 0) {
+        finishFrame();
+      }
+    }
+  }
+
+  // Packets are written to the link whole, so how much write() can take
+  // without blocking depends on escaping; report that it cannot tell.
+  int availableForWrite() {
+    return -1;
+  }
+
+  unsigned long time() const {
+    return link_->time();
+  }
+
+  unsigned long timeMicros() const {
+    return link_->timeMicros();
+  }
+
+  // Sends the bytes packed so far.
+  void flush() {
+    if (tx_length_ == 0) {
+      return;
+    }
+    // TX request with a 16-bit destination address. Frame ID 0 asks for no
+    // TX status reply; the options leave acknowledgements and retries on.
+    uint8_t header[kTxHeaderSize] = {
+      kStartDelimiter, 0, uint8_t(tx_length_ + kTxHeaderSize - 3),
+      kTx16Request, 0, uint8_t(host_address_ >> 8), uint8_t(host_address_), 0 };
+    uint8_t checksum = 0;
+    for (int i = 3; i < kTxHeaderSize; i++) {
+      checksum += header[i];
+    }
+    for (int i = 0; i < tx_length_; i++) {
+      checksum += tx_[i];
+    }
+    checksum = 0xff - checksum;
+    link_->write(header, 1);
+    writeEscaped(header + 1, kTxHeaderSize - 1);
+    writeEscaped(tx_, tx_length_);
+    writeEscaped(&checksum, 1);
+    tx_length_ = 0;
+  }
+
+ private:
+  enum {
+    kStartDelimiter = 0x7e,
+    kEscape = 0x7d,
+    kXon = 0x11,
+    kXoff = 0x13,
+    kTx16Request = 0x01,
+    kRx16Packet = 0x81,
+    // Delimiter, length, API ID, frame ID, address and options.
+    kTxHeaderSize = 8,
+    // API ID, source address, RSSI and options.
+    kRx16PacketHeaderSize = 5,
+    // Flags, topic ID and length of a rosserial frame.
+    kHeaderSize = 6,
+    // A rosserial frame without payload.
+    kMinFrameSize = kHeaderSize + 1
+  };
+
+  enum RxState { kIdle, kLengthHigh, kLengthLow, kData, kChecksum };
+
+  LinkT* link_;
+  uint16_t host_address_;
+  unsigned long flush_delay_;
+
+  uint8_t tx_[kMtu];
+  int tx_length_;
+  // When the first byte of tx_ was packed.
+  unsigned long tx_time_;
+  uint8_t header_[kHeaderSize];
+  int header_length_;
+  // Bytes of the current frame still to come after its header.
+  int frame_remaining_;
+
+  uint8_t packet_[kRx16PacketHeaderSize + kMtu];
+  RxState rx_state_;
+  int rx_length_;
+  int rx_count_;
+  uint8_t rx_checksum_;
+  bool rx_escape_;
+  // Payload of the last packet from the host not read yet.
+  const uint8_t* rx_data_;
+  int rx_remaining_;
+
+  void append(uint8_t data) {
+    if (tx_length_ == 0) {
+      tx_time_ = link_->time();
+    }
+    tx_[tx_length_++] = data;
+    if (tx_length_ == kMtu) {
+      flush();
+    }
+  }
+
+  void finishFrame() {
+    if (kMtu - tx_length_ < kMinFrameSize) {
+      flush();
+    }
+  }
+
+  void writeEscaped(uint8_t* data, int length) {
+    int start = 0;
+    for (int i = 0; i < length; i++) {
+      if (data[i] == kStartDelimiter || data[i] == kEscape ||
+          data[i] == kXon || data[i] == kXoff) {
+        if (i > start) {
+          link_->write(data + start, i - start);
+        }
+        uint8_t escaped[2] = { kEscape, uint8_t(data[i] ^ 0x20) };
+        link_->write(escaped, 2);
+        start = i + 1;
+      }
+    }
+    if (length > start) {
+      link_->write(data + start, length - start);
+    }
+  }
+
+  // Parses link input until an RF packet from the host has arrived.
+  // Returns false if the input runs out first.
+  bool receivePacket() {
+    int input;
+    while ((input = link_->read()) >= 0) {
+      uint8_t data = input;
+      if (data == kStartDelimiter) {
+        rx_state_ = kLengthHigh;
+        rx_escape_ = false;
+        continue;
+      }
+      if (rx_state_ == kIdle) {
+        continue;
+      }
+      if (data == kEscape) {
+        rx_escape_ = true;
+        continue;
+      }
+      if (rx_escape_) {
+        data ^= 0x20;
+        rx_escape_ = false;
+      }
+      switch (rx_state_) {
+        case kLengthHigh:
+          rx_length_ = data << 8;
+          rx_state_ = kLengthLow;
+          break;
+        case kLengthLow:
+          rx_length_ |= data;
+          rx_count_ = 0;
+          rx_checksum_ = 0;
+          rx_state_ = rx_length_ > 0 && rx_length_ <= int(sizeof(packet_)) ? kData : kIdle;
+          break;
+        case kData:
+          packet_[rx_count_++] = data;
+          rx_checksum_ += data;
+          if (rx_count_ == rx_length_) {
+            rx_state_ = kChecksum;
+          }
+          break;
+        case kChecksum:
+          rx_state_ = kIdle;
+          if (uint8_t(rx_checksum_ + data) == 0xff && packet_[0] == kRx16Packet &&
+              rx_length_ > kRx16PacketHeaderSize &&
+              ((packet_[1] << 8) | packet_[2]) == host_address_) {
+            rx_data_ = packet_ + kRx16PacketHeaderSize;
+            rx_remaining_ = rx_length_ - kRx16PacketHeaderSize;
+            return true;
+          }
+          break;
+        case kIdle:
+          break;
+      }
+    }
+    return false;
+  }
+
+  XBeeHardware(const XBeeHardware&);
+  void operator=(const XBeeHardware&);
+};
+
+}  // namespace ros
+
+#endif  // ROS_XBEE_HARDWARE_H_
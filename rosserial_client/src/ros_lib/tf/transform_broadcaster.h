@@ -35,15 +35,21 @@
 #ifndef ROS_TF_H_
 #define ROS_TF_H_
 
+#include <string.h>
+
+#include "ros/msg.h"
+#include "ros/publisher.h"
 #include "tfMessage.h"
 
 namespace tf
 {
 
+  // Publishes every transform in a tfMessage of its own.
   class TransformBroadcaster
   {
     public:
-      TransformBroadcaster() : publisher_("tf", &internal_msg)
+      template<typename NodeHandleT>
+      explicit TransformBroadcaster(NodeHandleT& nh) : publisher_("tf", &internal_msg)
       {
         nh.advertise(publisher_);
       }
@@ -60,7 +66,135 @@ namespace tf
       ros::Publisher publisher_;
   };
 
+  /* Collects the transforms sent during a cycle and publishes them as one
+   * tfMessage on flush(), typically once per loop() before spinOnce(). A
+   * transform replaces the one buffered for the same child frame, and the
+   * buffer is flushed early when it holds kCapacity transforms. Transforms
+   * are copied, but their frame ids must stay valid until flushed.
+   *
+   * Static transforms can be sent with sendStaticTransform(), which drops
+   * a transform that is unchanged since it was last sent and stamped less
+   * than the static period later, so that listeners still see it often
+   * enough to keep it.
+   */
+  template<int kCapacity = 4>
+  class BufferedTransformBroadcaster
+  {
+    public:
+      // static_period_ms of 0 sends static transforms like any other.
+      template<typename NodeHandleT>
+      explicit BufferedTransformBroadcaster(NodeHandleT& nh, unsigned long static_period_ms = 0)
+          : publisher_("tf", &internal_msg), count_(0), static_count_(0),
+            static_period_ms_(static_period_ms)
+      {
+        // transforms_length is a single byte.
+        (void) sizeof(ros::StaticCheck<(kCapacity > 0 && kCapacity <= 255)>);
+        nh.advertise(publisher_);
+      }
+
+      void sendTransform(const geometry_msgs::TransformStamped &transform)
+      {
+        for (int i = 0; i < count_; i++) {
+          if (strcmp(transforms_[i].child_frame_id, transform.child_frame_id) == 0) {
+            transforms_[i] = transform;
+            return;
+          }
+        }
+        if (count_ == kCapacity) {
+          flush();
+        }
+        transforms_[count_++] = transform;
+      }
+
+      void sendStaticTransform(const geometry_msgs::TransformStamped &transform)
+      {
+        if (static_period_ms_ > 0) {
+          int i = 0;
+          while (i < static_count_ &&
+                 strcmp(statics_[i].child_frame_id, transform.child_frame_id) != 0) {
+            i++;
+          }
+          if (i < static_count_) {
+            if (unchanged(statics_[i], transform) &&
+                elapsedMs(statics_[i].header.stamp, transform.header.stamp) < static_period_ms_) {
+              return;
+            }
+            statics_[i] = transform;
+          } else if (static_count_ < kCapacity) {
+            // Static transforms beyond the capacity are never dropped.
+            statics_[static_count_++] = transform;
+          }
+        }
+        sendTransform(transform);
+      }
+
+      // Publishes the buffered transforms. Returns the bytes published, or
+      // -1 if some could not be.
+      int flush()
+      {
+        if (count_ == 0) {
+          return 0;
+        }
+        int length = publish(transforms_, count_);
+        count_ = 0;
+        return length;
+      }
+
+      int getBufferedCount() const
+      {
+        return count_;
+      }
+
+    private:
+      tf::tfMessage internal_msg;
+      ros::Publisher publisher_;
+      geometry_msgs::TransformStamped transforms_[kCapacity];
+      int count_;
+      // Last static transform sent for each child frame.
+      geometry_msgs::TransformStamped statics_[kCapacity];
+      int static_count_;
+      unsigned long static_period_ms_;
+
+      // A batch too large for one frame is published in halves.
+      int publish(geometry_msgs::TransformStamped* transforms, int count)
+      {
+        internal_msg.transforms_length = count;
+        internal_msg.transforms = transforms;
+        int length = publisher_.publish(&internal_msg);
+        if (length >= 0 || count == 1) {
+          return length;
+        }
+        int half = count / 2;
+        int first = publish(transforms, half);
+        int second = publish(transforms + half, count - half);
+        return (first < 0 || second < 0) ? -1 : first + second;
+      }
+
+      static bool unchanged(const geometry_msgs::TransformStamped &a,
+                            const geometry_msgs::TransformStamped &b)
+      {
+        const geometry_msgs::Vector3 &p = a.transform.translation;
+        const geometry_msgs::Vector3 &q = b.transform.translation;
+        const geometry_msgs::Quaternion &r = a.transform.rotation;
+        const geometry_msgs::Quaternion &s = b.transform.rotation;
+        return strcmp(a.header.frame_id, b.header.frame_id) == 0 &&
+               p.x == q.x && p.y == q.y && p.z == q.z &&
+               r.x == s.x && r.y == s.y && r.z == s.z && r.w == s.w;
+      }
+
+      // Stamps going backwards count as a long time, the clock was reset.
+      static unsigned long elapsedMs(const ros::Time &from, const ros::Time &to)
+      {
+        if (to.sec < from.sec || (to.sec == from.sec && to.nsec < from.nsec)) {
+          return (unsigned long) -1;
+        }
+        return (to.sec - from.sec) * 1000 + (long) (to.nsec - from.nsec) / 1000000;
+      }
+
+      BufferedTransformBroadcaster(const BufferedTransformBroadcaster&);
+      void operator=(const BufferedTransformBroadcaster&);
+  };
+
 }
 
 #endif
-
@@ -40,7 +40,26 @@ make_library.py generates the Arduino rosserial library files.  It
 requires the location of your arduino libraries folder and the name of
 one or more packages for which you want to make libraries.
 
-rosrun rosserial_client make_library.py <library_path>  pkg_name [pkg2 pkg3 ...]
+rosrun rosserial_client make_library.py [--array-limits=<file>] [--target=<target>] <library_path>  pkg_name [pkg2 pkg3 ...]
+
+  --array-limits=<file>  Generate fixed-capacity storage for the
+                         variable-length arrays listed in <file> instead
+                         of growing them with realloc() on receive. Each
+                         line holds a scope and a maximum length:
+
+                           sensor_msgs/LaserScan.ranges 360
+                           sensor_msgs/LaserScan 64
+                           geometry_msgs 8
+
+                         A field entry overrides a message entry, which
+                         overrides a package entry.
+
+  --target=<target>      The platform the library is for: avr (default),
+                         arm32 or host. avr has no 64-bit double or
+                         integer arithmetic, so float64 fields are
+                         generated as float and int64/uint64 fields as 32
+                         bits, converted on the wire. The other targets
+                         use native double, int64_t and uint64_t.
 """
 
 import os
@@ -62,12 +81,27 @@ _TYPES = {
     'float32': ('float', 4),
     }
 
+# Primitive types each target handles natively on top of _TYPES. The rest
+# are narrowed by Float64DataType and Int64DataType.
+_NATIVE_64BIT_TYPES = {
+    'float64': ('double', 8),
+    'int64': ('int64_t', 8),
+    'uint64': ('uint64_t', 8),
+    }
+
+_TARGETS = {
+    'avr': {},
+    'arm32': _NATIVE_64BIT_TYPES,
+    'host': _NATIVE_64BIT_TYPES,
+    }
+
 
 def number_of_bytes_to_type(number_of_bytes):
   lookup = {
       1: 'uint8_t',
       2: 'uint16_t',
       4: 'uint32_t',
+      8: 'uint64_t',
       }
   return lookup[number_of_bytes]
 
@@ -84,6 +118,34 @@ class EnumerationType(object):
     stream.write('  enum { %s = %s };\n' % (self.name, str(self.value)))
 
 
+def view_offset(offset, n):
+  """C++ expression for offset + n, folding constants."""
+  if offset.isdigit():
+    return str(int(offset) + n)
+  if n == 0:
+    return offset
+  return '%s + %d' % (offset, n)
+
+
+def view_at(offset):
+  if offset == '0':
+    return 'buffer_', 'limit_'
+  if ' ' in offset:
+    return 'buffer_ + %s' % offset, 'limit_ - (%s)' % offset
+  return 'buffer_ + %s' % offset, 'limit_ - %s' % offset
+
+
+def write_view_size(stream, view):
+  """Advances offset past a field read through a view with wireSize()."""
+  stream.write('    {\n')
+  stream.write('      int size = %s.wireSize();\n' % view)
+  stream.write('      if (size < 0) {\n')
+  stream.write('        return -1;\n')
+  stream.write('      }\n')
+  stream.write('      offset += size;\n')
+  stream.write('    }\n')
+
+
 class PrimitiveDataType(object):
   """Our datatype is a C/C++ primitive."""
 
@@ -95,6 +157,35 @@ class PrimitiveDataType(object):
   def make_declaration(self, stream):
     stream.write('  %s %s;\n' % (self.type, self.name))
 
+  def fixed_size(self):
+    """Wire size in bytes if it does not depend on the value, else None."""
+    return self.number_of_bytes
+
+  def max_size(self):
+    """Largest wire size as (bytes, [(count, message type)]), or None if unbounded.
+
+    Nested message types contribute count times their kMaxSerializedSize.
+    """
+    return (self.fixed_size(), [])
+
+  def write_length(self, stream):
+    """Adds the wire size of a field without a fixed size to length."""
+    pass
+
+  def view_wire(self):
+    """Decoder for a fixed-size field in a view, None for views."""
+    return 'ros::Wire<%s>' % self.type
+
+  def view_type(self):
+    return self.type
+
+  def make_view_accessor(self, stream, offset):
+    stream.write('    return %s::read(%s);\n' % (self.view_wire(), view_at(offset)[0]))
+
+  def write_view_advance(self, stream):
+    """Advances offset past a field without a fixed size in a view."""
+    write_view_size(stream, '%s(buffer_ + offset, limit_ - offset)' % self.view_type())
+
   def serialize(self, stream):
     stream.write('    if (offset + sizeof(%s) > limit) {\n' % self.type)
     stream.write('      return -1;\n')
@@ -121,6 +212,24 @@ class PrimitiveDataType(object):
 class MessageDataType(PrimitiveDataType):
   """For when our data type is another message."""
 
+  def fixed_size(self):
+    return None
+
+  def max_size(self):
+    return (0, [(1, self.type)])
+
+  def write_length(self, stream):
+    stream.write('    length += this->%s.serializedLength();\n' % self.name)
+
+  def view_wire(self):
+    return None
+
+  def view_type(self):
+    return self.type + 'View'
+
+  def make_view_accessor(self, stream, offset):
+    stream.write('    return %s(%s, %s);\n' % ((self.view_type(),) + view_at(offset)))
+
   def serialize(self, stream):
     stream.write('    {\n')
     stream.write('      int result = %s.serialize(buffer + offset, limit - offset);\n' % self.name)
@@ -146,6 +255,15 @@ class Float64DataType(PrimitiveDataType):
   def make_declaration(self, stream):
     stream.write('  float %s;\n' % self.name )
 
+  def fixed_size(self):
+    return 8
+
+  def view_wire(self):
+    return 'ros::Float64Wire'
+
+  def view_type(self):
+    return 'float'
+
   def serialize(self, stream):
     stream.write('    if (offset + 8 > limit) {\n')
     stream.write('      return -1;\n')
@@ -198,8 +316,17 @@ class Int64DataType(PrimitiveDataType):
   def make_declaration(self, stream):
     stream.write('  int32_t %s;\n' % self.name )
 
+  def fixed_size(self):
+    return 8
+
+  def view_wire(self):
+    return 'ros::Int64Wire'
+
+  def view_type(self):
+    return 'int32_t'
+
   def serialize(self, stream):
-    stream.write('    if (offset + sizeof(float) > limit) {\n')
+    stream.write('    if (offset + 8 > limit) {\n')
     stream.write('      return -1;\n')
     stream.write('    }\n')
     for i in xrange(4):
@@ -208,6 +335,9 @@ class Int64DataType(PrimitiveDataType):
       stream.write('    buffer[offset++] = (this->%s > 0) ? 0: 255;\n' % self.name)
 
   def deserialize(self, stream):
+    stream.write('    if (offset + 8 > limit) {\n')
+    stream.write('      return -1;\n')
+    stream.write('    }\n')
     stream.write('    this->%s = 0;\n' % self.name)
     for i in xrange(4):
       stream.write('    this->%s += ((int32_t) buffer[offset++]) >> (8 * %d);\n' % (self.name, i))
@@ -220,6 +350,24 @@ class StringDataType(PrimitiveDataType):
   def make_declaration(self, stream):
     stream.write('  char* %s;\n' % self.name)
 
+  def fixed_size(self):
+    return None
+
+  def max_size(self):
+    return None
+
+  def write_length(self, stream):
+    stream.write('    length += 4 + strlen((const char*) this->%s);\n' % self.name)
+
+  def view_wire(self):
+    return None
+
+  def view_type(self):
+    return 'ros::StringView'
+
+  def make_view_accessor(self, stream, offset):
+    stream.write('    return ros::StringView(%s, %s);\n' % view_at(offset))
+
   def serialize(self, stream):
     # TODO(damonkohler): Pull out a variable for the length of the string? Have to make sure names don't clash.
     # Add an additional 4 bytes for the length field we just parsed.
@@ -247,7 +395,7 @@ class StringDataType(PrimitiveDataType):
     stream.write('        buffer[k-1] = buffer[k];\n')
     stream.write('      }\n')
     stream.write('      buffer[offset + length - 1] = 0;\n')
-    stream.write('      this->%s = (char*) buffer[offset - 1];\n' % self.name)
+    stream.write('      this->%s = (char*) (buffer + offset - 1);\n' % self.name)
     stream.write('      offset += length;\n')
     stream.write('    }\n')
 
@@ -262,6 +410,12 @@ class TimeDataType(PrimitiveDataType):
   def make_declaration(self, stream):
     stream.write('  %s %s;\n' % (self.type, self.name))
 
+  def fixed_size(self):
+    return 8
+
+  def view_wire(self):
+    return 'ros::TimeWire'
+
   def serialize(self, stream):
     self.sec.serialize(stream)
     self.nsec.serialize(stream)
@@ -281,6 +435,12 @@ class DurationDataType(PrimitiveDataType):
   def make_declaration(self, stream):
     stream.write('  %s %s;\n' % (self.type, self.name))
 
+  def fixed_size(self):
+    return 8
+
+  def view_wire(self):
+    return 'ros::DurationWire'
+
   def serialize(self, stream):
     self.sec.serialize(stream)
     self.nsec.serialize(stream)
@@ -292,38 +452,187 @@ class DurationDataType(PrimitiveDataType):
 
 class ArrayDataType(PrimitiveDataType):
 
-  def __init__(self, name, ty, number_of_bytes, cls, array_size=None):
+  def __init__(self, name, ty, number_of_bytes, cls, array_size=None, max_length=None):
     PrimitiveDataType.__init__(self, name, ty, number_of_bytes)
     self.size = array_size
     self.cls = cls
+    self.max_length = max_length  # Capacity of a bounded variable-length array.
+
+  def length_type(self):
+    if self.max_length > 255:
+      return 'uint16_t'
+    return 'unsigned char'
 
   def make_declaration(self, stream):
-    if self.size == None:
+    if self.max_length != None:
+      stream.write('  enum { %s_max_length = %d };\n' % (self.name, self.max_length))
+      stream.write('  %s %s_length;\n' % (self.length_type(), self.name))
+      stream.write('  %s %s[%d];\n' % (self.type, self.name, self.max_length))
+    elif self.size == None:
       stream.write('  unsigned char %s_length;\n' % self.name)
       stream.write('  %s st_%s;\n' % (self.type, self.name))  # Static instance for copy.
       stream.write('  %s* %s;\n' % (self.type, self.name))
     else:
       stream.write('  %s %s[%d];\n' % (self.type, self.name, self.size))
 
-  def serialize(self, stream):
-    c = self.cls(self.name + '[i]', self.type, self.number_of_bytes)
+  def element(self):
+    return self.cls(self.name + '[i]', self.type, self.number_of_bytes)
+
+  def fixed_size(self):
+    if self.size == None or self.max_length != None:
+      return None
+    element_size = self.element().fixed_size()
+    if element_size == None:
+      return None
+    return self.size * element_size
+
+  def max_size(self):
+    count = self.size
+    size = 0
+    if self.max_length != None:
+      count = self.max_length
+      size = 4
+    element = self.element().max_size()
+    if count == None or element == None:
+      return None
+    return (size + count * element[0], [(count * n, ty) for n, ty in element[1]])
+
+  def write_length(self, stream):
+    if self.fixed_size() != None:
+      return
+    count = str(self.size)
+    index_type = 'unsigned char'
+    if self.size == None:
+      count = self.name + '_length'
+      stream.write('    length += 4;\n')
+      if self.max_length != None:
+        index_type = self.length_type()
+    c = self.element()
+    element_size = c.fixed_size()
+    if element_size != None:
+      stream.write('    length += %s * %d;\n' % (count, element_size))
+      return
+    stream.write('    for (%s i = 0; i < %s; i++) {\n' % (index_type, count))
+    c.write_length(stream)
+    stream.write('    }\n')
+
+  def view_wire(self):
+    return None
+
+  def view_type(self):
+    c = self.element()
+    if c.view_wire() != None:
+      return 'ros::ArrayView<%s >' % c.view_wire()
+    return 'ros::SequenceView<%s>' % c.view_type()
+
+  def make_view_accessor(self, stream, offset):
     if self.size == None:
+      data = view_at(view_offset(offset, 4))
+      count = 'ros::Wire<uint32_t>::read(%s)' % view_at(offset)[0]
+    else:
+      data = view_at(offset)
+      count = str(self.size)
+    if self.element().view_wire() != None:
+      stream.write('    return %s(%s, %s);\n' % (self.view_type(), data[0], count))
+    else:
+      stream.write('    return %s(%s, %s, %s);\n' % (self.view_type(), data[0], count, data[1]))
+
+  def write_view_advance(self, stream):
+    c = self.element()
+    if self.size != None:
+      write_view_size(stream, '%s(buffer_ + offset, %d, limit_ - offset)' % (self.view_type(), self.size))
+      return
+    stream.write('    {\n')
+    stream.write('      if (offset + 4 > limit_) {\n')
+    stream.write('        return -1;\n')
+    stream.write('      }\n')
+    stream.write('      uint32_t length = ros::Wire<uint32_t>::read(buffer_ + offset);\n')
+    if c.view_wire() != None:
+      stream.write('      if (length > uint32_t(limit_ - offset - 4) / %d) {\n' % c.fixed_size())
+      stream.write('        return -1;\n')
+      stream.write('      }\n')
+      stream.write('      offset += 4 + length * %d;\n' % c.fixed_size())
+    else:
+      stream.write('      if (length > uint32_t(limit_ - offset - 4)) {\n')
+      stream.write('        return -1;\n')
+      stream.write('      }\n')
+      stream.write('      int size = %s(buffer_ + offset + 4, length, limit_ - offset - 4).wireSize();\n' % self.view_type())
+      stream.write('      if (size < 0) {\n')
+      stream.write('        return -1;\n')
+      stream.write('      }\n')
+      stream.write('      offset += 4 + size;\n')
+    stream.write('    }\n')
+
+  def bulk_copy(self):
+    """Primitive elements have the wire layout on little-endian targets."""
+    return self.cls is PrimitiveDataType
+
+  def _serialize_elements(self, stream, count, index_type):
+    if self.bulk_copy():
+      stream.write('    if (offset + %s * sizeof(%s) > limit) {\n' % (count, self.type))
+      stream.write('      return -1;\n')
+      stream.write('    }\n')
+      stream.write('    ros::copyToWire(buffer + offset, this->%s, %s);\n' % (self.name, count))
+      stream.write('    offset += %s * sizeof(%s);\n' % (count, self.type))
+      return
+    c = self.cls(self.name + '[i]', self.type, self.number_of_bytes)
+    stream.write('    for (%s i = 0; i < %s; i++) {\n' % (index_type, count))
+    c.serialize(stream)
+    stream.write('    }\n')
+
+  def _deserialize_elements(self, stream, count, index_type):
+    if self.bulk_copy():
+      stream.write('    if (offset + %s * sizeof(%s) > limit) {\n' % (count, self.type))
+      stream.write('      return -1;\n')
+      stream.write('    }\n')
+      stream.write('    ros::copyFromWire(this->%s, buffer + offset, %s);\n' % (self.name, count))
+      stream.write('    offset += %s * sizeof(%s);\n' % (count, self.type))
+      return
+    c = self.cls(self.name + '[i]', self.type, self.number_of_bytes)
+    stream.write('    for (%s i = 0; i < %s; i++) {\n' % (index_type, count))
+    c.deserialize(stream)
+    stream.write('    }\n')
+
+  def serialize(self, stream):
+    if self.max_length != None:
+      stream.write('    if (%s_length > %s_max_length || offset + 4 > limit) {\n' % (self.name, self.name))
+      stream.write('      return -1;\n')
+      stream.write('    }\n')
+      for i in xrange(4):
+        stream.write('    buffer[offset++] = (%s_length >> (8 * %d)) & 0xff;\n' % (self.name, i))
+      self._serialize_elements(stream, self.name + '_length', self.length_type())
+    elif self.size == None:
       # Serialize length.
+      stream.write('    if (offset + 4 > limit) {\n')
+      stream.write('      return -1;\n')
+      stream.write('    }\n')
       stream.write('    *(buffer + offset++) = %s_length;\n' % self.name)
       stream.write('    *(buffer + offset++) = 0;\n')
       stream.write('    *(buffer + offset++) = 0;\n')
       stream.write('    *(buffer + offset++) = 0;\n')
-      stream.write('    for (unsigned char i = 0; i < %s_length; i++) {\n' % self.name)
-      c.serialize(stream)
-      stream.write('    }\n')
+      self._serialize_elements(stream, self.name + '_length', 'unsigned char')
     else:
-      stream.write('    unsigned char * %s_val = (unsigned char *) this->%s;\n' % (self.name, self.name))
-      stream.write('    for (unsigned char i = 0; i < %d; i++) {\n' % self.size)
-      c.serialize(stream)
-      stream.write('    }\n')
+      if not self.bulk_copy():
+        stream.write('    unsigned char * %s_val = (unsigned char *) this->%s;\n' % (self.name, self.name))
+      self._serialize_elements(stream, str(self.size), 'unsigned char')
 
   def deserialize(self, stream):
-    if self.size == None:
+    if self.max_length != None:
+      # Elements are decoded in place; nothing is allocated.
+      stream.write('    {\n')
+      stream.write('      if (offset + 4 > limit) {\n')
+      stream.write('        return -1;\n')
+      stream.write('      }\n')
+      stream.write('      uint32_t length = 0;\n')
+      for i in xrange(4):
+        stream.write('      length |= uint32_t(buffer[offset++]) << (8 * %d);\n' % i)
+      stream.write('      if (length > %s_max_length) {\n' % self.name)
+      stream.write('        return -1;\n')
+      stream.write('      }\n')
+      stream.write('      %s_length = length;\n' % self.name)
+      stream.write('    }\n')
+      self._deserialize_elements(stream, self.name + '_length', self.length_type())
+    elif self.size == None:
       c = self.cls('st_' + self.name, self.type, self.number_of_bytes)
       # Deserialize length.
       stream.write('    {\n')
@@ -334,26 +643,55 @@ class ArrayDataType(PrimitiveDataType):
       stream.write('      offset += 3;\n')
       stream.write('      %s_length = length;\n' % self.name)
       stream.write('    }\n')
+      if self.bulk_copy():
+        self._deserialize_elements(stream, self.name + '_length', 'unsigned char')
+        return
       # Copy to array.
       stream.write('    for (unsigned char i = 0; i < %s_length; i++) {\n' % (self.name) )
       c.deserialize(stream)
       stream.write('      memcpy(&(this->%s[i]), &(this->st_%s), sizeof(%s));\n' % (self.name, self.name, self.type))
       stream.write('    }\n')
     else:
-      c = self.cls(self.name + '[i]', self.type, self.number_of_bytes)
-      stream.write('    unsigned char* %s_val = (unsigned char*) this->%s;\n' % (self.name, self.name))
-      stream.write('    for (unsigned char i = 0; i < %d; i++) {\n' % self.size)
-      c.deserialize(stream)
-      stream.write('    }\n')
+      if not self.bulk_copy():
+        stream.write('    unsigned char* %s_val = (unsigned char*) this->%s;\n' % (self.name, self.name))
+      self._deserialize_elements(stream, str(self.size), 'unsigned char')
+
+
+class ArrayLimits(object):
+  """Maximum lengths for variable-length arrays, read from a config file."""
+
+  def __init__(self, path=None):
+    self.limits = dict()
+    if path == None:
+      return
+    for line in open(path).readlines():
+      if line.find("#") > -1:
+        line = line[0:line.find("#")]
+      l = line.split()
+      if len(l) == 0:
+        continue
+      if len(l) != 2:
+        raise ValueError("Bad array limit in %s: %s" % (path, line.strip()))
+      self.limits[l[0]] = int(l[1])
+
+  def get(self, package, message, field):
+    """Returns the most specific limit for a field, or None."""
+    for scope in ('%s/%s.%s' % (package, message, field),
+                  '%s/%s' % (package, message),
+                  package):
+      if scope in self.limits:
+        return self.limits[scope]
+    return None
 
 
 class Message(object):
   """Parses message definitions into something we can export. """
 
-  def __init__(self, name, package, definition):
+  def __init__(self, name, package, definition, array_limits=ArrayLimits(), target='avr'):
     self.name = name      # name of message/class
     self.package = package    # package we reside in
     self.includes = list()    # other files we must include
+    self.type_name = '"%s/%s"' % (package, name)  # C++ expression for getType()
 
     self.data = list()      # data types for code generation
     self.enums = list()
@@ -403,7 +741,10 @@ class Message(object):
         size = 0
         if type_package:
           cls = MessageDataType
-        if type_name == 'float64':
+        if type_name in _TARGETS[target]:
+          code_type = _TARGETS[target][type_name][0]
+          size = _TARGETS[target][type_name][1]
+        elif type_name == 'float64':
           cls = Float64DataType
           code_type = 'float'
         elif type_name == 'time':
@@ -426,7 +767,8 @@ class Message(object):
           code_type = _TYPES[type_name][0]
           size = _TYPES[type_name][1]
         if type_array:
-          self.data.append( ArrayDataType(name, code_type, size, cls, type_array_size ) )
+          self.data.append( ArrayDataType(name, code_type, size, cls, type_array_size,
+                                          self._max_length(array_limits, name, type_array_size)) )
         else:
           self.data.append(cls(name, code_type, size))
       except:
@@ -443,16 +785,49 @@ class Message(object):
           if type_package+"/"+type_name not in self.includes:
             self.includes.append(type_package+"/"+type_name)
           if type_array:
-            self.data.append( ArrayDataType(name, type_package + "::" + type_name, size, cls, type_array_size) )
+            self.data.append( ArrayDataType(name, type_package + "::" + type_name, size, cls, type_array_size,
+                                            self._max_length(array_limits, name, type_array_size)) )
           else:
             self.data.append( MessageDataType(name, type_package + "::" + type_name, 0) )
 
+  def _max_length(self, array_limits, field, array_size):
+    if array_size != None:
+      return None
+    return array_limits.get(self.package, self.name, field)
+
+  def _field_runs(self):
+    """Groups consecutive primitive scalars so they share one bounds check.
+
+    Returns the fields in order, with each run of primitive scalars
+    replaced by a list of them.
+    """
+    runs = []
+    for d in self.data:
+      if type(d) is PrimitiveDataType:
+        if not runs or not isinstance(runs[-1], list):
+          runs.append([])
+        runs[-1].append(d)
+      else:
+        runs.append(d)
+    return runs
+
+  def _write_run_bounds_check(self, stream, run):
+    stream.write('    if (offset + %d > limit) {\n' % sum([d.number_of_bytes for d in run]))
+    stream.write('      return -1;\n')
+    stream.write('    }\n')
+
   def _write_serializer(self, stream):
     stream.write('\n')
     stream.write('  virtual int serialize(unsigned char* buffer, int limit) {\n')
     stream.write('    int offset = 0;\n')
-    for d in self.data:
-      d.serialize(stream)
+    for run in self._field_runs():
+      if isinstance(run, list):
+        self._write_run_bounds_check(stream, run)
+        for d in run:
+          stream.write('    ros::copyToWire<%s>(buffer + offset, &this->%s, 1);\n' % (d.type, d.name))
+          stream.write('    offset += %d;\n' % d.number_of_bytes)
+      else:
+        run.serialize(stream)
     stream.write('    return offset;\n');
     stream.write('  }\n')
     stream.write('\n')
@@ -460,18 +835,60 @@ class Message(object):
   def _write_deserializer(self, stream):
     stream.write('  virtual int deserialize(unsigned char* buffer, int limit) {\n')
     stream.write('    int offset = 0;\n')
-    for d in self.data:
-      d.deserialize(stream)
+    for run in self._field_runs():
+      if isinstance(run, list):
+        self._write_run_bounds_check(stream, run)
+        for d in run:
+          stream.write('    ros::copyFromWire<%s>(&this->%s, buffer + offset, 1);\n' % (d.type, d.name))
+          stream.write('    offset += %d;\n' % d.number_of_bytes)
+      else:
+        run.deserialize(stream)
     stream.write('    return offset;\n');
     stream.write('  }\n')
     stream.write('\n')
 
+  def _write_length(self, stream):
+    stream.write('  virtual int serializedLength() {\n')
+    stream.write('    int length = %d;\n' % sum([d.fixed_size() for d in self.data if d.fixed_size() != None]))
+    for d in self.data:
+      d.write_length(stream)
+    stream.write('    return length;\n')
+    stream.write('  }\n')
+    stream.write('\n')
+
+  def _max_serialized_size(self):
+    """C++ constant expression for kMaxSerializedSize, -1 if unbounded."""
+    size = 0
+    nested = []
+    for d in self.data:
+      m = d.max_size()
+      if m == None:
+        return '-1'
+      size += m[0]
+      nested.extend(m[1])
+    # Enums are 16 bits on AVR.
+    if size > 32767:
+      return '-1'
+    if not nested:
+      return str(size)
+    terms = []
+    if size > 0:
+      terms.append(str(size))
+    for count, ty in nested:
+      if count == 1:
+        terms.append('%s::kMaxSerializedSize' % ty)
+      else:
+        terms.append('%d * %s::kMaxSerializedSize' % (count, ty))
+    unbounded = ' || '.join(['%s::kMaxSerializedSize < 0' % ty for ty in sorted(set([ty for n, ty in nested]))])
+    return '(%s) ? -1 : %s' % (unbounded, ' + '.join(terms))
+
   def _write_std_includes(self, stream):
     stream.write('#include <stdint.h>\n')
     stream.write('#include <string.h>\n')
     stream.write('#include <stdlib.h>\n')
     stream.write('\n')
     stream.write('#include "ros/msg.h"\n')
+    stream.write('#include "ros/msg_view.h"\n')
 
   def _write_msg_includes(self, stream):
     for include in self.includes:
@@ -482,16 +899,88 @@ class Message(object):
       d.make_declaration(stream)
     for e in self.enums:
       e.make_declaration(stream)
+    stream.write('  enum { kMaxSerializedSize = %s };\n' % self._max_serialized_size())
 
   def _write_getType(self, stream):
     stream.write('  const char* getType() { return "%s/%s"; };\n' % (self.package, self.name))
 
+  def _write_view(self, stream):
+    """Read-only view that decodes fields lazily from a received frame."""
+    view = self.name + 'View'
+    stream.write('class %s {\n' % view)
+    stream.write(' public:\n')
+    stream.write('  %s(const unsigned char* buffer, int limit) : buffer_(buffer), limit_(limit) {}\n' % view)
+    stream.write('\n')
+    # Fields are found at a constant distance from the end of the last
+    # field without a fixed size, which fieldOffset() walks to.
+    base = None
+    offset = 0
+    for i in xrange(len(self.data)):
+      d = self.data[i]
+      stream.write('  %s %s() const {\n' % (d.view_type(), d.name))
+      if base == None:
+        d.make_view_accessor(stream, str(offset))
+      else:
+        stream.write('    int offset = %s;\n' % view_offset('fieldOffset(%d)' % base, offset))
+        d.make_view_accessor(stream, 'offset')
+      stream.write('  }\n')
+      stream.write('\n')
+      if d.fixed_size() == None:
+        base = i + 1
+        offset = 0
+      else:
+        offset += d.fixed_size()
+    stream.write('  // Bytes the message occupies in the buffer, or -1 if it overruns limit.\n')
+    stream.write('  int wireSize() const {\n')
+    stream.write('    return fieldOffset(%d);\n' % len(self.data))
+    stream.write('  }\n')
+    stream.write('\n')
+    stream.write('  static const char* getType() { return %s; }\n' % self.type_name)
+    stream.write('\n')
+    stream.write(' private:\n')
+    stream.write('  const unsigned char* buffer_;\n')
+    stream.write('  int limit_;\n')
+    stream.write('\n')
+    # field is only compared after a variable size field that isn't last.
+    if [d for d in self.data[:-1] if d.fixed_size() == None]:
+      stream.write('  int fieldOffset(int field) const {\n')
+    else:
+      stream.write('  int fieldOffset(int) const {\n')
+    stream.write('    int offset = 0;\n')
+    pending = 0
+    for i in xrange(len(self.data)):
+      d = self.data[i]
+      if d.fixed_size() != None:
+        pending += d.fixed_size()
+        continue
+      if pending > 0:
+        stream.write('    offset += %d;\n' % pending)
+        pending = 0
+      d.write_view_advance(stream)
+      if i + 1 < len(self.data):
+        stream.write('    if (field == %d) {\n' % (i + 1))
+        stream.write('      return offset;\n')
+        stream.write('    }\n')
+    if pending > 0:
+      stream.write('    offset += %d;\n' % pending)
+    stream.write('    if (offset > limit_) {\n')
+    stream.write('      return -1;\n')
+    stream.write('    }\n')
+    stream.write('    return offset;\n')
+    stream.write('  }\n')
+    stream.write('};\n')
+    stream.write('\n')
+
   def _write_impl(self, stream):
+    self._write_view(stream)
     stream.write('class %s : public ros::Msg {\n' % self.name)
     stream.write(' public:\n')
+    stream.write('  typedef %sView View;\n' % self.name)
+    stream.write('\n')
     self._write_data(stream)
     self._write_serializer(stream)
     self._write_deserializer(stream)
+    self._write_length(stream)
     self._write_getType(stream)
     stream.write('\n')
     stream.write('};\n')
@@ -515,11 +1004,13 @@ class Message(object):
 
 class Service(object):
 
-  def __init__(self, name, package, definition):
+  def __init__(self, name, package, definition, array_limits=ArrayLimits(), target='avr'):
     """
     @param name -  name of service
     @param package - name of service package
     @param definition - list of lines of  definition
+    @param array_limits - capacities of bounded variable-length arrays
+    @param target - name of the platform profile in _TARGETS
     """
 
     self.name = name
@@ -534,8 +1025,8 @@ class Service(object):
     self.req_def = definition[0:sep_line]
     self.resp_def = definition[sep_line+1:]
 
-    self.req = Message(name + "Request", package, self.req_def)
-    self.resp = Message(name + "Response", package, self.resp_def)
+    self.req = Message(name + "Request", package, self.req_def, array_limits, target)
+    self.resp = Message(name + "Response", package, self.resp_def, array_limits, target)
 
   def make_header(self, stream):
     guard = 'ROS_SERVICE_%s_H_' % self.name.upper()
@@ -558,6 +1049,8 @@ class Service(object):
       out.write('  const char* getType() { return %s; };\n' % name)
 
     _write_getType = lambda out: write_type(out, self.name.upper())
+    self.req.type_name = self.name.upper()
+    self.resp.type_name = self.name.upper()
     self.req._write_getType = _write_getType
     self.resp._write_getType = _write_getType
 
@@ -574,7 +1067,7 @@ class Service(object):
 class ArduinoLibraryMaker(object):
   """Create an Arduino Library from a set of Message Definitions. """
 
-  def __init__(self, package):
+  def __init__(self, package, array_limits=ArrayLimits(), target='avr'):
     """Initialize by finding location and all messages in this package. """
     self.name = package
     print "\nExporting " + package +"\n",
@@ -590,7 +1083,7 @@ class ArduinoLibraryMaker(object):
           # Add to list of messages.
           print "%s," % path[0:-4],
           definition = open(self.pkg_dir + "/msg/" + path).readlines()
-          self.messages.append(Message(path[0:-4], self.name, definition))
+          self.messages.append(Message(path[0:-4], self.name, definition, array_limits, target))
       print "\n"
 
     sys.stdout.write('Services:\n  ')
@@ -602,7 +1095,7 @@ class ArduinoLibraryMaker(object):
           # add to list of messages
           print "%s," % path[0:-4],
           definition = open(self.pkg_dir + "/srv/" + path).readlines()
-          self.messages.append( Service(path[0:-4], self.name, definition) )
+          self.messages.append( Service(path[0:-4], self.name, definition, array_limits, target) )
       print "\n"
 
   def generate(self, path_to_output):
@@ -617,18 +1110,32 @@ class ArduinoLibraryMaker(object):
 
 
 if __name__== "__main__":
-  if (len(sys.argv) <3):
+  args = list()
+  array_limits = ArrayLimits()
+  target = 'avr'
+  for arg in sys.argv[1:]:
+    if arg.startswith("--array-limits="):
+      array_limits = ArrayLimits(arg[len("--array-limits="):])
+    elif arg.startswith("--target="):
+      target = arg[len("--target="):]
+      if target not in _TARGETS:
+        print __usage__
+        exit()
+    else:
+      args.append(arg)
+
+  if (len(args) < 2):
     print __usage__
     exit()
 
-  path = sys.argv[1]
+  path = args[0]
   if path[-1] == "/":
     path = path[0:-1]
   print "\nExporting to %s" % path
 
   # make libraries
-  packages = sys.argv[2:]
+  packages = args[1:]
   for msg_package in packages:
-    lm = ArduinoLibraryMaker(msg_package)
+    lm = ArduinoLibraryMaker(msg_package, array_limits, target)
     lm.generate(path)
 
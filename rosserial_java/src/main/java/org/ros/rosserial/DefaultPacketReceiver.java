@@ -16,6 +16,8 @@
 
 package org.ros.rosserial;
 
+import java.nio.ByteBuffer;
+
 /**
  * @author damonkohler@google.com (Damon Kohler)
  */
@@ -28,7 +30,7 @@ class DefaultPacketReceiver implements PacketReceiver {
 	}
 
 	@Override
-	public void receive(int topicId, byte[] data) {
+	public void receive(int topicId, ByteBuffer data) {
 		protocol.receivePacket(topicId, data);
 	}
 }
@@ -35,9 +35,12 @@ package org.ros.rosserial;
 import com.google.common.annotations.VisibleForTesting;
 
 import org.apache.commons.logging.Log;
+import org.ros.message.Message;
 
 import java.io.IOException;
 import java.io.OutputStream;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
 
 /**
  * Protocol handler for rosserial.
@@ -51,30 +54,79 @@ class DefaultPacketSender implements PacketSender {
    */
   private static final byte[] FLAGS = { (byte) 0xff, (byte) 0xff };
 
+  private static final int INITIAL_BUFFER_SIZE = 512;
+
   private final Log log;
   private final OutputStream outputStream;
 
+  /**
+   * Packets are assembled here and written out in one call. The buffer is
+   * reused and only grows when a packet does not fit.
+   */
+  private ByteBuffer buffer;
+
   public DefaultPacketSender(OutputStream outputStream, Log log) {
     this.log = log;
     this.outputStream = outputStream;
+    allocateBuffer(INITIAL_BUFFER_SIZE);
   }
 
   @Override
-  public void send(byte[] data) {
+  public synchronized void send(byte[] data) {
+    prepareBuffer(data.length);
+    buffer.put(data);
+    write();
+  }
+
+  @Override
+  public synchronized void send(int topicId, Message message) {
+    int serializationLength = message.serializationLength();
+    prepareBuffer(serializationLength + 4);
+    buffer.putShort((short) topicId);
+    buffer.putShort((short) serializationLength);
+    message.serialize(buffer, 0);
+    write();
+  }
+
+  /**
+   * Start a packet with dataLength bytes between the flags and the checksum.
+   */
+  private void prepareBuffer(int dataLength) {
+    int packetLength = FLAGS.length + dataLength + 1;
+    if (buffer.capacity() < packetLength) {
+      allocateBuffer(Math.max(packetLength, 2 * buffer.capacity()));
+    }
+    buffer.clear();
+    buffer.put(FLAGS);
+  }
+
+  private void allocateBuffer(int capacity) {
+    buffer = ByteBuffer.allocate(capacity);
+    buffer.order(ByteOrder.LITTLE_ENDIAN);
+  }
+
+  private void write() {
+    byte[] packet = buffer.array();
+    int dataLength = buffer.position() - FLAGS.length;
+    buffer.put(calculateChecksum(packet, FLAGS.length, dataLength));
     try {
-      outputStream.write(FLAGS);
-      outputStream.write(data);
-      outputStream.write(calculateChecksum(data));
+      outputStream.write(packet, 0, buffer.position());
       outputStream.flush();
     } catch (IOException e) {
+      byte[] data = new byte[dataLength];
+      System.arraycopy(packet, FLAGS.length, data, 0, dataLength);
       log.error("IO error while writing packet: " + BinaryUtils.byteArrayToHexString(data), e);
     }
   }
 
   @VisibleForTesting
   static byte calculateChecksum(byte[] data) {
+    return calculateChecksum(data, 0, data.length);
+  }
+
+  private static byte calculateChecksum(byte[] data, int offset, int length) {
     int chk = 0;
-    for (int i = 0; i < data.length; i++) {
+    for (int i = offset; i < offset + length; i++) {
       chk += 0xff & data[i];
     }
     chk = 255 - chk % 256;
@@ -0,0 +1,117 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2011, Willow Garage, Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Willow Garage, Inc. nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+package org.ros.rosserial;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+/**
+ * Rebuilds the samples of a topic listed with ENCODING_DELTA, as
+ * rosserial_client's DeltaFrame sends them. Each starts with its kind and an
+ * 8 bit sequence number. A keyframe holds the whole serialized sample, a
+ * delta its XOR with the previous sample as pairs of runs: unchanged bytes to
+ * skip, then changed bytes. After a missed sequence number or a malformed
+ * delta, samples are dropped until the next keyframe.
+ */
+class DeltaDecoder {
+
+  private static final int KEYFRAME = 0;
+  private static final int DELTA = 1;
+
+  // Grows to the longest sample seen and is reused, as is its wrapper.
+  private byte[] sample = new byte[0];
+  private ByteBuffer buffer = wrap(sample);
+  private int length;
+  private boolean valid;
+  private int sequence;
+
+  /**
+   * @param data
+   *          the frame payload
+   * @return the serialized sample, or null if it can't be rebuilt; only valid
+   *         until the next call
+   */
+  public ByteBuffer decode(ByteBuffer data) {
+    if (data.remaining() < 2) {
+      valid = false;
+      return null;
+    }
+    int kind = data.get() & 0xff;
+    int sequence = data.get() & 0xff;
+    if (kind == KEYFRAME) {
+      length = data.remaining();
+      if (length > sample.length) {
+        sample = new byte[length];
+        buffer = wrap(sample);
+      }
+      data.get(sample, 0, length);
+      valid = true;
+    } else if (kind != DELTA || !valid || sequence != ((this.sequence + 1) & 0xff)
+        || !applyDelta(data)) {
+      valid = false;
+    }
+    this.sequence = sequence;
+    if (!valid) {
+      return null;
+    }
+    buffer.clear();
+    buffer.limit(length);
+    return buffer;
+  }
+
+  private static ByteBuffer wrap(byte[] array) {
+    ByteBuffer buffer = ByteBuffer.wrap(array);
+    buffer.order(ByteOrder.LITTLE_ENDIAN);
+    return buffer;
+  }
+
+  private boolean applyDelta(ByteBuffer delta) {
+    int i = 0;
+    while (delta.hasRemaining()) {
+      if (delta.remaining() < 2) {
+        return false;
+      }
+      int unchanged = delta.get() & 0xff;
+      int changed = delta.get() & 0xff;
+      i += unchanged;
+      if (i + changed > length || changed > delta.remaining()) {
+        return false;
+      }
+      for (int j = 0; j < changed; j++) {
+        sample[i + j] ^= delta.get();
+      }
+      i += changed;
+    }
+    return true;
+  }
+}
@@ -0,0 +1,142 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2011, Willow Garage, Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Willow Garage, Inc. nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+package org.ros.rosserial;
+
+import com.google.common.collect.Maps;
+
+import java.nio.BufferUnderflowException;
+import java.nio.ByteBuffer;
+import java.nio.charset.Charset;
+import java.util.IllegalFormatException;
+import java.util.Locale;
+import java.util.Map;
+import java.util.regex.Matcher;
+import java.util.regex.Pattern;
+
+/**
+ * Formats binary log messages, which rosserial_client sends as the ID of a
+ * printf format registered during topic negotiation and the raw arguments:
+ * 4 byte integers and floats and terminated strings, read by the conversions
+ * of the format.
+ */
+class LogFormatter {
+
+  /**
+   * A printf conversion: flags, width and precision, length modifier, type.
+   */
+  private static final Pattern CONVERSION = Pattern
+      .compile("%([-+ #0]*\\d*(?:\\.\\d*)?)(?:hh|h|ll|l|L|j|z|t)?([diouxXeEfFgGcs%])");
+  private static final Charset CHARSET = Charset.forName("UTF-8");
+
+  private final Map<Integer, String> formats;
+
+  public LogFormatter() {
+    formats = Maps.newHashMap();
+  }
+
+  public void addFormat(int formatId, byte[] format) {
+    formats.put(formatId, new String(format, CHARSET));
+  }
+
+  /**
+   * @param data
+   *          the little endian arguments of the message
+   * @return the formatted message, or null if the format is unknown or does
+   *         not match the arguments
+   */
+  public String format(int formatId, ByteBuffer data) {
+    String format = formats.get(formatId);
+    if (format == null) {
+      return null;
+    }
+    StringBuffer text = new StringBuffer();
+    Matcher matcher = CONVERSION.matcher(format);
+    try {
+      while (matcher.find()) {
+        String spec = "%" + matcher.group(1);
+        char conversion = matcher.group(2).charAt(0);
+        String replacement;
+        switch (conversion) {
+        case '%':
+          replacement = "%";
+          break;
+        case 's':
+          replacement = String.format(Locale.US, spec + "s", readString(data));
+          break;
+        case 'd':
+        case 'i':
+          replacement = String.format(Locale.US, spec + "d", data.getInt());
+          break;
+        case 'u':
+          replacement = String.format(Locale.US, spec + "d", data.getInt() & 0xffffffffL);
+          break;
+        case 'o':
+        case 'x':
+        case 'X':
+          replacement = String.format(Locale.US, spec + conversion, data.getInt() & 0xffffffffL);
+          break;
+        case 'c':
+          replacement = String.format(Locale.US, spec + "c", data.getInt());
+          break;
+        case 'F':
+          replacement = String.format(Locale.US, spec + "f", data.getFloat());
+          break;
+        default:
+          replacement = String.format(Locale.US, spec + conversion, data.getFloat());
+          break;
+        }
+        matcher.appendReplacement(text, Matcher.quoteReplacement(replacement));
+      }
+    } catch (BufferUnderflowException e) {
+      return null;
+    } catch (IllegalFormatException e) {
+      return null;
+    }
+    matcher.appendTail(text);
+    return text.toString();
+  }
+
+  private static String readString(ByteBuffer data) {
+    int start = data.position();
+    int end = start;
+    while (end < data.limit() && data.get(end) != 0) {
+      end++;
+    }
+    byte[] bytes = new byte[end - start];
+    data.get(bytes);
+    if (data.hasRemaining()) {
+      data.get();
+    }
+    return new String(bytes, CHARSET);
+  }
+}
@@ -60,7 +60,6 @@ class MessageListenerForwarding implements
 
 	@Override
 	public void onNewMessage(Message message) {
-		byte[] data = Protocol.constructMessage(topicId, message);
-		packetSender.send(data);
+		packetSender.send(topicId, message);
 	}
 }
\ No newline at end of file
@@ -55,7 +55,7 @@ class PacketBuilder {
 
   private PacketState packetState;
   private short topicId;
-  private short dataLength;
+  private int dataLength;
 
   /**
    * Used for debugging output only.
@@ -71,6 +71,40 @@ class PacketBuilder {
     reset();
   }
 
+  /**
+   * Parse length bytes of input starting at offset. Packet payloads are
+   * copied in bulk, and nothing is allocated per packet.
+   * 
+   * @throws IllegalStateException
+   *           if the input contained a protocol error, after parsing all of
+   *           it
+   */
+  public void addBytes(byte[] input, int offset, int length) {
+    IllegalStateException error = null;
+    int end = offset + length;
+    while (offset < end) {
+      try {
+        if (packetState == PacketState.DATA) {
+          int count = Math.min(dataLength - data.position(), end - offset);
+          data.put(input, offset, count);
+          offset += count;
+          if (data.position() == dataLength) {
+            packetState = PacketState.CHECKSUM;
+          }
+        } else {
+          addByte(input[offset++]);
+        }
+      } catch (IllegalStateException e) {
+        if (error == null) {
+          error = e;
+        }
+      }
+    }
+    if (error != null) {
+      throw error;
+    }
+  }
+
   public void addByte(byte inputByte) {
     if (DEBUG) {
       System.out.println(String.format("%8s (byte %3d): %x", packetState.name(), byteNumber,
@@ -97,7 +131,7 @@ class PacketBuilder {
         if (header.position() == 4) {
           header.flip();
           topicId = header.getShort();
-          dataLength = header.getShort();
+          dataLength = header.getShort() & 0xffff;
           if (DEBUG) {
             System.out.println("Topic ID: " + topicId);
             System.out.println("Data length: " + dataLength);
@@ -121,11 +155,13 @@ class PacketBuilder {
         break;
       case CHECKSUM:
         int checksum = 0;
+        byte[] headerBytes = header.array();
         for (int i = 0; i < HEADER_BUFFER_SIZE; i++) {
-          checksum += header.get(i);
+          checksum += headerBytes[i];
         }
+        byte[] dataBytes = data.array();
         for (int i = 0; i < dataLength; i++) {
-          checksum += data.get(i);
+          checksum += dataBytes[i];
         }
         checksum = 255 - (checksum % 256);
         if ((byte) checksum != inputByte) {
@@ -133,17 +169,53 @@ class PacketBuilder {
           throw new IllegalStateException(String.format("Invalid checksum: %x != %x", checksum,
               inputByte));
         }
-        byte buffer[] = new byte[dataLength];
-        data.flip();
-        data.get(buffer);
-        packetReceiver.receive(topicId, buffer);
-        reset();
+        short packetTopicId = topicId;
+        int packetLength = dataLength;
+        try {
+          if (packetTopicId == Protocol.TOPIC_BATCH) {
+            receiveBatch(packetLength);
+          } else {
+            deliver(packetTopicId, 0, packetLength);
+          }
+        } finally {
+          reset();
+        }
         break;
       default:
         throw new RosRuntimeException("Unknown packet state.");
     }
   }
 
+  /**
+   * Deliver each (topic ID, length, payload) record of a batched packet of
+   * length bytes.
+   */
+  private void receiveBatch(int length) {
+    int offset = 0;
+    while (length - offset >= HEADER_BUFFER_SIZE) {
+      // deliver() narrowed the limit to the previous record.
+      data.limit(length);
+      short recordTopicId = data.getShort(offset);
+      int recordLength = data.getShort(offset + 2) & 0xffff;
+      offset += HEADER_BUFFER_SIZE;
+      if (recordLength > length - offset) {
+        throw new IllegalStateException("Batched record exceeds packet size.");
+      }
+      deliver(recordTopicId, offset, recordLength);
+      offset += recordLength;
+    }
+  }
+
+  /**
+   * Hand length bytes of the data buffer starting at offset to the
+   * receiver, as a view of the buffer itself.
+   */
+  private void deliver(int packetTopicId, int offset, int length) {
+    data.limit(offset + length);
+    data.position(offset);
+    packetReceiver.receive(packetTopicId, data);
+  }
+
   /**
    * Reset packet parsing state machine.
    */
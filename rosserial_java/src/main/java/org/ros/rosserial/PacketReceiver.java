@@ -16,11 +16,21 @@
 
 package org.ros.rosserial;
 
+import java.nio.ByteBuffer;
+
 /**
  * @author damonkohler@google.com (Damon Kohler)
  */
 interface PacketReceiver {
 
-	void receive(int topicId, byte[] data);
+	/**
+	 * Receive a packet.
+	 * 
+	 * @param data
+	 *            little endian view of the payload, between its position and
+	 *            limit. It is reused for the next packet, so it is only valid
+	 *            until this method returns.
+	 */
+	void receive(int topicId, ByteBuffer data);
 
 }
@@ -32,6 +32,8 @@
 
 package org.ros.rosserial;
 
+import org.ros.message.Message;
+
 /**
  * Handles communication to the remote endpoint.
  * 
@@ -46,4 +48,14 @@ public interface PacketSender {
 	 *            the data to send
 	 */
 	void send(byte[] data);
+
+	/**
+	 * Serialize a message and send it to the remote endpoint.
+	 * 
+	 * @param topicId
+	 *            the ID of the topic the message is sent on
+	 * @param message
+	 *            the message to send
+	 */
+	void send(int topicId, Message message);
 }
\ No newline at end of file
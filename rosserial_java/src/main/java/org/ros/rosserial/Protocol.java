@@ -56,6 +56,7 @@ class Protocol {
   // All IDS greater than 100 are publishers or subscribers.
   static final int TOPIC_PUBLISHERS = 0;
   static final int TOPIC_SUBSCRIBERS = 1;
+  static final int TOPIC_BATCH = 6;
   static final int TOPIC_TIME = 10;
 
   // Topic negotiation will be retried after the sync timeout. The Arduino
@@ -86,6 +87,11 @@ class Protocol {
    */
   private final Map<Integer, MessageDeserializer<?>> messageDeserializers;
 
+  /**
+   * Topic ID to the decoder of a delta encoded publisher.
+   */
+  private final Map<Integer, DeltaDecoder> deltaDecoders;
+
   /**
    * {@link PacketSender} for writing to the other endpoint.
    */
@@ -93,12 +99,38 @@ class Protocol {
 
   private final Proxy proxy;
 
+  /**
+   * Hash of the complete topic table from the last connection, or null if
+   * there is none.
+   */
+  private Integer topicHash;
+
+  /**
+   * Hash of the topics listed since the last negotiation request.
+   */
+  private final TopicHash listingHash;
+
+  /**
+   * Formats of the binary log messages, kept across connections like the
+   * topic table.
+   */
+  private final LogFormatter logFormatter;
+
+  /**
+   * Reused for the replies to time requests.
+   */
+  private final org.ros.message.std_msgs.Time time;
+
   public Protocol(final Node node, PacketSender packetSender) {
     this.node = node;
     this.packetSender = packetSender;
     proxy = new Proxy(node);
     topicIds = Maps.newHashMap();
     messageDeserializers = Maps.newHashMap();
+    deltaDecoders = Maps.newHashMap();
+    listingHash = new TopicHash();
+    logFormatter = new LogFormatter();
+    time = new org.ros.message.std_msgs.Time();
     watchdogTimer = new WatchdogTimer(SYNC_TIMEOUT, new Runnable() {
       @Override
       public void run() {
@@ -113,12 +145,25 @@ class Protocol {
    */
   public void negotiateTopics() {
     node.getLog().info("Starting topic negotiation.");
-    packetSender.send(NEGOTIATE_TOPICS_REQUEST);
+    listingHash.reset();
+    if (topicHash == null) {
+      packetSender.send(NEGOTIATE_TOPICS_REQUEST);
+    } else {
+      // Offer the topics kept from the last connection. The client only
+      // lists its topics if they changed.
+      ByteBuffer buffer = ByteBuffer.allocate(8);
+      buffer.order(ByteOrder.LITTLE_ENDIAN);
+      buffer.putShort((short) TOPIC_PUBLISHERS);
+      buffer.putShort((short) 4);
+      buffer.putInt(topicHash);
+      packetSender.send(buffer.array());
+    }
   }
 
   /**
    * Construct a valid protocol message. This take the id and m, serializes them
-   * and return the raw bytes to be sent
+   * and return the raw bytes to be sent. {@link PacketSender#send(int, Message)}
+   * serializes into the sender's buffer instead, without allocating.
    */
   public static byte[] constructMessage(int topicId, Message message) {
     // TODO(damonkohler): Switch to using MessageSerializer.
@@ -138,8 +183,11 @@ class Protocol {
    * 
    * @param topic
    *          the TopicInfo message describing the topic
+   * @param encoding
+   *          the encoding the topic's samples are sent with
    */
-  private void registerTopic(TopicInfo topicInfo) {
+  private void registerTopic(TopicInfo topicInfo, int encoding) {
+    listingHash.add(topicInfo, encoding);
     String topicName = topicInfo.topic_name;
     int topicId = topicInfo.topic_id;
     if (topicIds.containsKey(topicName) && topicIds.get(topicName) == topicId) {
@@ -155,9 +203,17 @@ class Protocol {
    * 
    * @param topic
    *          the TopicInfo message describing the topic
+   * @param encoding
+   *          the encoding the publisher's samples are sent with
    */
-  private void registerPublisher(TopicInfo topicInfo) {
-    registerTopic(topicInfo);
+  private void registerPublisher(TopicInfo topicInfo, int encoding) {
+    registerTopic(topicInfo, encoding);
+    // Deltas of an earlier listing don't apply to samples of this one.
+    if (encoding == TopicInfo.ENCODING_DELTA) {
+      deltaDecoders.put(topicInfo.topic_id, new DeltaDecoder());
+    } else {
+      deltaDecoders.remove(topicInfo.topic_id);
+    }
     proxy.registerPublisher(topicInfo.topic_id, topicInfo.topic_name, topicInfo.message_type);
   }
 
@@ -168,7 +224,7 @@ class Protocol {
    *          the TopicInfo message describing the topic
    */
   private void registerSubscriber(TopicInfo topicInfo) {
-    registerTopic(topicInfo);
+    registerTopic(topicInfo, TopicInfo.ENCODING_NONE);
     int topicId = topicInfo.topic_id;
     MessageListenerForwarding listener = new MessageListenerForwarding(topicId, packetSender);
     proxy.registerSubscriber(topicId, topicInfo.topic_name, topicInfo.message_type, listener);
@@ -189,38 +245,43 @@ class Protocol {
    * @param topicId
    *          ID of the message topic
    * @param data
-   *          the serialized message data
+   *          the serialized message data, only valid until this method
+   *          returns
    */
-  public void receivePacket(int topicId, byte[] data) {
+  public void receivePacket(int topicId, ByteBuffer data) {
     if (DEBUG) {
       System.out.println("Received data packet for topic ID: " + topicId);
-      System.out.println(BinaryUtils.byteArrayToHexString(data));
+      System.out.println(BinaryUtils.byteArrayToHexString(toArray(data.duplicate())));
     }
-    TopicInfo topicInfo = new TopicInfo();
     switch (topicId) {
-    case TopicInfo.ID_PUBLISHER:
-      try {
-        topicInfo.deserialize(data);
-      } catch (Exception e) {
-        node.getLog().error(e);
-        return;
+    case TopicInfo.ID_PUBLISHER: {
+      byte[] listing = toArray(data);
+      TopicInfo topicInfo = readTopicInfo(listing);
+      if (topicInfo != null) {
+        registerPublisher(topicInfo, listedEncoding(topicInfo, listing));
       }
-      registerPublisher(topicInfo);
       break;
-    case TopicInfo.ID_SUBSCRIBER:
-      try {
-        topicInfo.deserialize(data);
-      } catch (Exception e) {
-        node.getLog().error(e);
-        return;
+    }
+    case TopicInfo.ID_SUBSCRIBER: {
+      TopicInfo topicInfo = readTopicInfo(toArray(data));
+      if (topicInfo != null) {
+        registerSubscriber(topicInfo);
       }
-      registerSubscriber(topicInfo);
       break;
+    }
     case TopicInfo.ID_SERVICE_SERVER:
-      throw new UnsupportedOperationException();
-    case TopicInfo.ID_SERVICE_CLIENT:
-      throw new UnsupportedOperationException();
+    case TopicInfo.ID_SERVICE_CLIENT: {
+      TopicInfo topicInfo = readTopicInfo(toArray(data));
+      if (topicInfo != null) {
+        // Services are not forwarded yet. They are only hashed, so that the
+        // listing still counts as complete, and their calls are dropped.
+        listingHash.add(topicInfo, TopicInfo.ENCODING_NONE);
+        node.getLog().warn("Services are not supported yet, ignoring " + topicInfo.topic_name);
+      }
+      break;
+    }
     case TopicInfo.ID_PARAMETER_REQUEST:
+    case TopicInfo.ID_PARAMETER_BATCH:
       // NOTE(damonkohler): It is safe to simply ignore this request until
       // parameters are supported. The client will timeout waiting for a
       // response.
@@ -229,20 +290,44 @@ class Protocol {
     case TopicInfo.ID_LOG:
       handleLogging(data);
       break;
+    case TopicInfo.ID_LOG_FORMAT:
+      handleLogFormat(data);
+      break;
+    case TopicInfo.ID_BINARY_LOG:
+      handleBinaryLog(data);
+      break;
+    case TopicInfo.ID_TOPIC_HASH:
+      handleTopicHash(data);
+      break;
+    case TopicInfo.ID_DIAGNOSTICS:
+      // Link statistics are only reported by clients built with
+      // ROSSERIAL_DIAGNOSTICS and are not republished here yet.
+      break;
+    case TopicInfo.ID_BAUD_RATE:
+      // Baud rate offers are not taken up. The device only switches when
+      // told to, so it stays at the rate the link was opened with.
+      break;
     case TopicInfo.ID_TIME:
-      org.ros.message.std_msgs.Time time = new org.ros.message.std_msgs.Time();
       time.data = node.getCurrentTime();
-      packetSender.send(constructMessage(TOPIC_TIME, time));
+      packetSender.send(TOPIC_TIME, time);
       watchdogTimer.pulse();
       break;
     default:
       MessageDeserializer<?> messageDeserializer = messageDeserializers.get(topicId);
+      DeltaDecoder deltaDecoder = deltaDecoders.get(topicId);
+      if (deltaDecoder != null) {
+        data = deltaDecoder.decode(data);
+        if (data == null) {
+          if (DEBUG) {
+            System.out.println("Dropped a delta on topic " + topicId + ", waiting for a keyframe");
+          }
+          return;
+        }
+      }
       if (messageDeserializer != null) {
-        ByteBuffer buffer = ByteBuffer.wrap(data);
-        buffer.order(ByteOrder.LITTLE_ENDIAN);
         Message message;
         try {
-          message = (Message) messageDeserializer.deserialize(buffer);
+          message = (Message) messageDeserializer.deserialize(data);
         } catch (Exception e) {
           node.getLog().error(e);
           return;
@@ -254,6 +339,28 @@ class Protocol {
     }
   }
 
+  /**
+   * Keeps the topic table for the next connection once the client has
+   * confirmed that it is complete.
+   * 
+   * @param data
+   *          the client's topic hash as a serialized std_msgs/UInt32
+   */
+  private void handleTopicHash(ByteBuffer data) {
+    if (data.remaining() < 4) {
+      return;
+    }
+    int hash = data.getInt();
+    if (topicHash != null && topicHash == hash) {
+      node.getLog().info("Topics unchanged since the last connection.");
+    } else if (hash == listingHash.getValue()) {
+      topicHash = hash;
+    } else {
+      node.getLog().warn("Topic listing incomplete, it will be requested again on reconnect.");
+      topicHash = null;
+    }
+  }
+
   /**
    * Handle Logging takes the log message from rosserial and rebroadcasts it via
    * rosout at the appropriate logging level.
@@ -261,30 +368,109 @@ class Protocol {
    * @param data
    *          the serialized message data
    */
-  private void handleLogging(byte[] data) {
+  private void handleLogging(ByteBuffer data) {
     Log log = new Log();
     try {
-      log.deserialize(data);
+      log.deserialize(toArray(data));
     } catch (Exception e) {
       node.getLog().error(e);
       return;
     }
-    switch (log.level) {
+    log(log.level, log.msg);
+  }
+
+  /**
+   * Registers the format of binary log messages with the ID it starts with.
+   * 
+   * @param data
+   *          the 16 bit format ID followed by the format string
+   */
+  private void handleLogFormat(ByteBuffer data) {
+    if (data.remaining() < 2) {
+      return;
+    }
+    int formatId = data.getShort() & 0xffff;
+    byte[] format = toArray(data);
+    logFormatter.addFormat(formatId, format);
+    listingHash.addLogFormat(formatId, format);
+  }
+
+  /**
+   * Formats a binary log message and rebroadcasts it via rosout.
+   * 
+   * @param data
+   *          the level, the 16 bit format ID and the raw arguments
+   */
+  private void handleBinaryLog(ByteBuffer data) {
+    if (data.remaining() < 3) {
+      return;
+    }
+    int level = data.get();
+    int formatId = data.getShort() & 0xffff;
+    String message = logFormatter.format(formatId, data);
+    if (message == null) {
+      node.getLog().error("Failed to format binary log message with format " + formatId);
+      return;
+    }
+    log(level, message);
+  }
+
+  private void log(int level, String message) {
+    switch (level) {
     case Log.DEBUG:
-      node.getLog().debug(log.msg);
+      node.getLog().debug(message);
       break;
     case Log.INFO:
-      node.getLog().info(log.msg);
+      node.getLog().info(message);
       break;
     case Log.WARN:
-      node.getLog().warn(log.msg);
+      node.getLog().warn(message);
       break;
     case Log.ERROR:
-      node.getLog().error(log.msg);
+      node.getLog().error(message);
       break;
     case Log.FATAL:
-      node.getLog().fatal(log.msg);
+      node.getLog().fatal(message);
       break;
     }
   }
+
+  /**
+   * Reads a topic negotiation. TopicInfo is only allocated for these, not for
+   * every packet.
+   * 
+   * @return the TopicInfo, or null if it is malformed
+   */
+  private TopicInfo readTopicInfo(byte[] listing) {
+    TopicInfo topicInfo = new TopicInfo();
+    try {
+      topicInfo.deserialize(listing);
+    } catch (Exception e) {
+      node.getLog().error(e);
+      return null;
+    }
+    return topicInfo;
+  }
+
+  /**
+   * The encoding of a publisher listing, which follows the serialized TopicInfo
+   * unless it is ENCODING_NONE.
+   */
+  private static int listedEncoding(TopicInfo topicInfo, byte[] listing) {
+    int length = topicInfo.serializationLength();
+    if (listing.length > length) {
+      return listing[length] & 0xff;
+    }
+    return TopicInfo.ENCODING_NONE;
+  }
+
+  /**
+   * Copy the remaining bytes of a received packet for message classes that
+   * only deserialize from arrays. Used for control packets, which are rare.
+   */
+  private static byte[] toArray(ByteBuffer data) {
+    byte[] array = new byte[data.remaining()];
+    data.get(array);
+    return array;
+  }
 }
@@ -57,6 +57,12 @@ public class RosSerial implements NodeMain {
 
   private static final int STREAM_BUFFER_SIZE = 8192;
 
+  /**
+   * Input is handed to the {@link PacketBuilder} in chunks of up to this many
+   * bytes.
+   */
+  private static final int READ_BUFFER_SIZE = 1024;
+
   /**
    * Output stream for the serial line used for communication.
    */
@@ -94,18 +100,19 @@ public class RosSerial implements NodeMain {
     protocol = new Protocol(node, packetSender);
     PacketReceiver packetReceiver = new DefaultPacketReceiver(protocol);
     final PacketBuilder packetBuilder = new PacketBuilder(packetReceiver);
+    final byte[] readBuffer = new byte[READ_BUFFER_SIZE];
     protocol.start();
     node.executeCancellableLoop(new CancellableLoop() {
       @Override
       protected void loop() throws InterruptedException {
         try {
-          int inputByte = inputStream.read();
-          if (inputByte == -1) {
+          int count = inputStream.read(readBuffer);
+          if (count == -1) {
             // The connection has been closed.
             cancel();
             return;
           }
-          packetBuilder.addByte((byte) inputByte);
+          packetBuilder.addBytes(readBuffer, 0, count);
         } catch (IllegalStateException e) {
           if (DEBUG) {
             node.getLog().error("Protocol error.", e);
@@ -0,0 +1,100 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2011, Willow Garage, Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Willow Garage, Inc. nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+package org.ros.rosserial;
+
+import org.ros.message.rosserial_msgs.TopicInfo;
+
+import java.nio.charset.Charset;
+
+/**
+ * 32 bit FNV-1a hash of a topic table, computed the same way as
+ * rosserial_client hashes its own: over the ID, name and type of each topic,
+ * in the order the client lists them.
+ */
+class TopicHash {
+
+  private static final int OFFSET_BASIS = 0x811c9dc5;
+  private static final int PRIME = 16777619;
+  private static final Charset CHARSET = Charset.forName("UTF-8");
+
+  private int value;
+
+  public TopicHash() {
+    reset();
+  }
+
+  public void reset() {
+    value = OFFSET_BASIS;
+  }
+
+  public void add(TopicInfo topicInfo, int encoding) {
+    addByte(topicInfo.topic_id & 0xff);
+    addByte((topicInfo.topic_id >> 8) & 0xff);
+    addString(topicInfo.topic_name);
+    addString(topicInfo.message_type);
+    // Only hashed if there is one, as on the client.
+    if (encoding != TopicInfo.ENCODING_NONE) {
+      addByte(encoding & 0xff);
+    }
+  }
+
+  /**
+   * Adds a log format, which counts as a topic named after the format with an
+   * empty type.
+   */
+  public void addLogFormat(int formatId, byte[] format) {
+    addByte(formatId & 0xff);
+    addByte((formatId >> 8) & 0xff);
+    for (byte b : format) {
+      addByte(b & 0xff);
+    }
+    addByte(0);
+    addByte(0);
+  }
+
+  public int getValue() {
+    return value;
+  }
+
+  private void addString(String string) {
+    for (byte b : string.getBytes(CHARSET)) {
+      addByte(b & 0xff);
+    }
+    // The terminator keeps the boundary between name and type significant.
+    addByte(0);
+  }
+
+  private void addByte(int b) {
+    value = (value ^ b) * PRIME;
+  }
+}
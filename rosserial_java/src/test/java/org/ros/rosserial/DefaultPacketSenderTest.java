@@ -0,0 +1,84 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2011, Willow Garage, Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Willow Garage, Inc. nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+package org.ros.rosserial;
+
+import static org.junit.Assert.assertArrayEquals;
+
+import org.junit.Test;
+
+import java.io.ByteArrayOutputStream;
+
+public class DefaultPacketSenderTest {
+
+	private static byte[] frame(byte[] data) {
+		byte[] packet = new byte[data.length + 3];
+		packet[0] = (byte) 0xFF;
+		packet[1] = (byte) 0xFF;
+		System.arraycopy(data, 0, packet, 2, data.length);
+		packet[packet.length - 1] = DefaultPacketSender.calculateChecksum(data);
+		return packet;
+	}
+
+	@Test
+	public void testSendMessage() {
+		ByteArrayOutputStream output = new ByteArrayOutputStream();
+		DefaultPacketSender sender = new DefaultPacketSender(output, null);
+		org.ros.message.std_msgs.String message = new org.ros.message.std_msgs.String();
+		message.data = "hello";
+		sender.send(101, message);
+		assertArrayEquals(frame(Protocol.constructMessage(101, message)), output.toByteArray());
+	}
+
+	@Test
+	public void testBufferGrows() {
+		ByteArrayOutputStream output = new ByteArrayOutputStream();
+		DefaultPacketSender sender = new DefaultPacketSender(output, null);
+		org.ros.message.std_msgs.String message = new org.ros.message.std_msgs.String();
+		StringBuilder data = new StringBuilder();
+		for (int i = 0; i < 1000; i++) {
+			data.append((char) ('a' + i % 26));
+		}
+		message.data = data.toString();
+		sender.send(102, message);
+		message.data = "short";
+		sender.send(103, message);
+		ByteArrayOutputStream expected = new ByteArrayOutputStream();
+		message.data = data.toString();
+		byte[] first = frame(Protocol.constructMessage(102, message));
+		expected.write(first, 0, first.length);
+		message.data = "short";
+		byte[] second = frame(Protocol.constructMessage(103, message));
+		expected.write(second, 0, second.length);
+		assertArrayEquals(expected.toByteArray(), output.toByteArray());
+	}
+}
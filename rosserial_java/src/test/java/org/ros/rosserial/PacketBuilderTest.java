@@ -21,6 +21,8 @@ import static org.junit.Assert.fail;
 
 import java.nio.ByteBuffer;
 import java.nio.ByteOrder;
+import java.util.ArrayList;
+import java.util.List;
 
 import org.junit.Test;
 import org.ros.message.rosserial_msgs.TopicInfo;
@@ -34,9 +36,9 @@ public class PacketBuilderTest {
 	public void testTopicNegotiation() {
 		PacketBuilder builder = new PacketBuilder(new PacketReceiver() {
 			@Override
-			public void receive(int topicId, byte[] data) {
+			public void receive(int topicId, ByteBuffer data) {
 				assertEquals(0, topicId);
-				assertEquals(0, data.length);
+				assertEquals(0, data.remaining());
 			}
 		});
 		assertEquals(PacketState.FLAGA, builder.getPacketState());
@@ -60,9 +62,9 @@ public class PacketBuilderTest {
 	public void testInvalidChecksum() {
 		PacketBuilder builder = new PacketBuilder(new PacketReceiver() {
 			@Override
-			public void receive(int topicId, byte[] data) {
+			public void receive(int topicId, ByteBuffer data) {
 				assertEquals(0, topicId);
-				assertEquals(0, data.length);
+				assertEquals(0, data.remaining());
 			}
 		});
 		assertEquals(PacketState.FLAGA, builder.getPacketState());
@@ -102,11 +104,13 @@ public class PacketBuilderTest {
 
 		PacketBuilder builder = new PacketBuilder(new PacketReceiver() {
 			@Override
-			public void receive(int topicId, byte[] data) {
+			public void receive(int topicId, ByteBuffer data) {
 				assertEquals(0, topicId);
-				assertEquals(topicInfo.serializationLength(), data.length);
+				assertEquals(topicInfo.serializationLength(), data.remaining());
+				byte[] bytes = new byte[data.remaining()];
+				data.get(bytes);
 				TopicInfo receivedTopicInfo = new TopicInfo();
-				receivedTopicInfo.deserialize(data);
+				receivedTopicInfo.deserialize(bytes);
 				assertEquals(topicInfo.message_type,
 						receivedTopicInfo.message_type);
 				assertEquals(topicInfo.topic_id, receivedTopicInfo.topic_id);
@@ -130,4 +134,91 @@ public class PacketBuilderTest {
 				.calculateChecksum(serializedTopicInfo.array()));
 		assertEquals(PacketState.FLAGA, builder.getPacketState());
 	}
+
+	@Test
+	public void testBatch() {
+		final List<Integer> topicIds = new ArrayList<Integer>();
+		final List<Integer> lengths = new ArrayList<Integer>();
+		PacketBuilder builder = new PacketBuilder(new PacketReceiver() {
+			@Override
+			public void receive(int topicId, ByteBuffer data) {
+				topicIds.add(topicId);
+				lengths.add(data.remaining());
+			}
+		});
+		// Two records, (101, 2 bytes) and (102, 1 byte), under one header.
+		byte[] packet = { (byte) Protocol.TOPIC_BATCH, 0, 11, 0, 101, 0, 2, 0,
+				(byte) 0xAB, (byte) 0xCD, 102, 0, 1, 0, 7 };
+		builder.addByte((byte) 0xFF);
+		builder.addByte((byte) 0xFF);
+		for (int i = 0; i < packet.length; i++) {
+			builder.addByte(packet[i]);
+		}
+		builder.addByte(DefaultPacketSender.calculateChecksum(packet));
+		assertEquals(PacketState.FLAGA, builder.getPacketState());
+		assertEquals(2, topicIds.size());
+		assertEquals(101, (int) topicIds.get(0));
+		assertEquals(2, (int) lengths.get(0));
+		assertEquals(102, (int) topicIds.get(1));
+		assertEquals(1, (int) lengths.get(1));
+	}
+
+	@Test
+	public void testAddBytes() {
+		final List<Integer> topicIds = new ArrayList<Integer>();
+		final List<Integer> values = new ArrayList<Integer>();
+		PacketBuilder builder = new PacketBuilder(new PacketReceiver() {
+			@Override
+			public void receive(int topicId, ByteBuffer data) {
+				topicIds.add(topicId);
+				values.add(data.getInt());
+			}
+		});
+		// Noise, then two packets back to back, fed in chunks that split the
+		// header, the payload and the checksum.
+		byte[] first = { 101, 0, 4, 0, 1, 2, 3, 4 };
+		byte[] second = { 102, 0, 4, 0, 5, 6, 7, 8 };
+		ByteBuffer input = ByteBuffer.allocate(3 + 2 * (first.length + 3));
+		input.put((byte) 0x42).put((byte) 0xFF).put((byte) 0x00);
+		input.put((byte) 0xFF).put((byte) 0xFF).put(first)
+				.put(DefaultPacketSender.calculateChecksum(first));
+		input.put((byte) 0xFF).put((byte) 0xFF).put(second)
+				.put(DefaultPacketSender.calculateChecksum(second));
+		byte[] bytes = input.array();
+		try {
+			builder.addBytes(bytes, 0, 6);
+			fail("Should have thrown an IllegalStateException.");
+		} catch (IllegalStateException e) {
+			// The noise is reported once the whole chunk is parsed.
+		}
+		builder.addBytes(bytes, 6, 5);
+		assertEquals(0, topicIds.size());
+		builder.addBytes(bytes, 11, 9);
+		builder.addBytes(bytes, 20, bytes.length - 20);
+		assertEquals(PacketState.FLAGA, builder.getPacketState());
+		assertEquals(2, topicIds.size());
+		assertEquals(101, (int) topicIds.get(0));
+		assertEquals(0x04030201, (int) values.get(0));
+		assertEquals(102, (int) topicIds.get(1));
+		assertEquals(0x08070605, (int) values.get(1));
+	}
+
+	@Test
+	public void testOversizedPacket() {
+		PacketBuilder builder = new PacketBuilder(new PacketReceiver() {
+			@Override
+			public void receive(int topicId, ByteBuffer data) {
+				fail("Should not have received a packet.");
+			}
+		});
+		// A length of 0x8000 must not be read as negative.
+		byte[] header = { (byte) 0xFF, (byte) 0xFF, 101, 0, 0, (byte) 0x80 };
+		try {
+			builder.addBytes(header, 0, header.length);
+			fail("Should have thrown an IllegalStateException.");
+		} catch (IllegalStateException e) {
+			// The data size exceeds the maximum.
+		}
+		assertEquals(PacketState.FLAGA, builder.getPacketState());
+	}
 }
@@ -0,0 +1,68 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2011, Willow Garage, Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Willow Garage, Inc. nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+package org.ros.rosserial;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertFalse;
+
+import org.junit.Test;
+import org.ros.message.rosserial_msgs.TopicInfo;
+
+public class TopicHashTest {
+
+	private static TopicInfo topic(int id, String name, String type) {
+		TopicInfo topicInfo = new TopicInfo();
+		topicInfo.topic_id = id;
+		topicInfo.topic_name = name;
+		topicInfo.message_type = type;
+		return topicInfo;
+	}
+
+	@Test
+	public void testEmpty() {
+		assertEquals(0x811c9dc5, new TopicHash().getValue());
+	}
+
+	@Test
+	public void testMatchesClient() {
+		// Value computed by rosserial_client for the same topic table.
+		TopicHash hash = new TopicHash();
+		hash.add(topic(102, "chatter", "std_msgs/String"), TopicInfo.ENCODING_NONE);
+		hash.add(topic(100, "led", "std_msgs/UInt32"), TopicInfo.ENCODING_NONE);
+		assertEquals(0x89d0f493, hash.getValue());
+		hash.reset();
+		hash.add(topic(100, "led", "std_msgs/UInt32"), TopicInfo.ENCODING_NONE);
+		hash.add(topic(102, "chatter", "std_msgs/String"), TopicInfo.ENCODING_NONE);
+		assertFalse(hash.getValue() == 0x89d0f493);
+	}
+}
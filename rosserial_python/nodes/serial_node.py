@@ -47,13 +47,17 @@ if __name__=="__main__":
 
     port_name = rospy.get_param('~port','/dev/ttyACM0')
     baud = int(rospy.get_param('~baud','115200'))
+    # longest payload the device sends, to skip false frame starts early
+    max_frame_length = rospy.get_param('~max_frame_length', None)
+    # rates to switch to if the device offers them, [] to stay at ~baud
+    baud_rates = rospy.get_param('~baud_rates', None)
 
     sys.argv = rospy.myargv(argv=sys.argv)
 
     if len(sys.argv) == 2 :
         port_name  = sys.argv[1]
     rospy.loginfo("Connected on %s at %d baud" % (port_name,baud) )
-    client = SerialClient(port_name, baud)
+    client = SerialClient(port_name, baud, max_frame_length=max_frame_length, baud_rates=baud_rates)
     try:
         client.run()
     except KeyboardInterrupt:
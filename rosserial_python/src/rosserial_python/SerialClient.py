@@ -39,15 +39,84 @@ import roslib; roslib.load_manifest("rosserial_python")
 import rospy
 
 import thread
+import threading
 from serial import *
 import StringIO
 
-from std_msgs.msg import Time
+from std_msgs.msg import Time, UInt32
+from diagnostic_msgs.msg import DiagnosticArray, DiagnosticStatus, KeyValue
 from rosserial_msgs.msg import *
 from rosserial_msgs.srv import *
 
 import time
 import struct
+import re
+
+# 32 bit FNV-1a, as used by rosserial_client to hash its topic table.
+FNV_OFFSET_BASIS = 2166136261
+FNV_PRIME = 16777619
+
+# Baud rates the host can switch to if the device offers them.
+BAUD_RATES = [57600, 115200, 230400, 460800, 500000, 921600, 1000000]
+# Seconds the device has to answer at a new baud rate.
+BAUD_SWITCH_TIMEOUT = 2.0
+# Checksum errors between two time syncs above which the rate is lowered.
+BAUD_ERROR_THRESHOLD = 10
+
+def hash_topic(h, topic_id, topic_name, message_type, encoding=TopicInfo.ENCODING_NONE):
+    """ Adds one topic of a listing to the hash of the topic table. The
+        encoding is only hashed if there is one.
+    """
+    data = struct.pack("<H", topic_id) + topic_name + '\0' + message_type + '\0'
+    if encoding != TopicInfo.ENCODING_NONE:
+        data += chr(encoding)
+    for c in data:
+        h = ((h ^ ord(c)) * FNV_PRIME) & 0xffffffff
+    return h
+
+def listed_encoding(m, data):
+    """ The encoding of a publisher, which follows its TopicInfo in the
+        listing unless it is ENCODING_NONE.
+    """
+    # The topic ID and three string lengths, then the strings.
+    length = 14 + len(m.topic_name) + len(m.message_type) + len(m.md5_checksum)
+    return ord(data[length]) if len(data) > length else TopicInfo.ENCODING_NONE
+
+# A printf conversion: flags, width and precision, length modifier, type.
+LOG_CONVERSION = re.compile(r"%([-+ #0]*\d*(?:\.\d*)?)(?:hh|h|ll|l|L|j|z|t)?([diouxXeEfFgGcs%])")
+
+def compile_log_format(format):
+    """ Turn the printf format of binary log messages into a Python format
+        and the struct codes of its arguments, as rosserial_client's
+        LogRecord sends them. Length modifiers are dropped since every
+        integer is sent as 4 bytes.
+    """
+    codes = []
+    def convert(match):
+        spec, conversion = match.groups()
+        if conversion in "di":
+            codes.append("i")
+        elif conversion in "ouxXc":
+            codes.append("I")
+        elif conversion == "s":
+            codes.append("s")
+        elif conversion != "%":
+            codes.append("f")
+        return "%" + spec + conversion
+    return LOG_CONVERSION.sub(convert, format), codes
+
+def histogram_values(name, counts):
+    """ Label the buckets of a LinkStatistics duration histogram. """
+    values = []
+    for i in range(len(counts)):
+        if i == 0:
+            label = "%s under 16 us" % name
+        elif i == len(counts) - 1:
+            label = "%s %d us and over" % (name, 8 << i)
+        else:
+            label = "%s %d-%d us" % (name, 8 << i, (16 << i) - 1)
+        values.append(KeyValue(label, str(counts[i])))
+    return values
 
 def load_pkg_module(package):
     #check if its in the python path
@@ -69,13 +138,63 @@ def load_pkg_module(package):
     return m
 
 
+class DeltaDecoder:
+    """
+        Rebuilds the samples of a topic listed with ENCODING_DELTA, as
+        rosserial_client's DeltaFrame sends them: keyframes hold the whole
+        sample, deltas the XOR with the previous one as pairs of runs of
+        unchanged and changed bytes.
+    """
+    KEYFRAME = 0
+    DELTA = 1
+
+    def __init__(self):
+        self.previous = None
+        self.sequence = None
+
+    def decode(self, data):
+        """ Return the serialized sample in data, or None if it can't be
+            rebuilt, which lasts until the next keyframe.
+        """
+        if len(data) < 2:
+            return None
+        kind, sequence = struct.unpack("BB", data[:2])
+        sample = None
+        if kind == self.KEYFRAME:
+            sample = data[2:]
+        elif kind == self.DELTA and self.previous != None and sequence == (self.sequence + 1) % 256:
+            sample = self.applyDelta(data[2:])
+        self.previous = sample
+        self.sequence = sequence
+        return sample
+
+    def applyDelta(self, delta):
+        sample = bytearray(self.previous)
+        i = 0
+        offset = 0
+        while offset < len(delta):
+            if offset + 2 > len(delta):
+                return None
+            unchanged, changed = struct.unpack("BB", delta[offset:offset + 2])
+            offset += 2
+            i += unchanged
+            if i + changed > len(sample) or offset + changed > len(delta):
+                return None
+            for j in range(changed):
+                sample[i + j] ^= ord(delta[offset + j])
+            i += changed
+            offset += changed
+        return str(sample)
+
+
 class Publisher:
     """
         Prototype of a forwarding publisher.
     """
-    def __init__(self, topic, message_type):
+    def __init__(self, topic, message_type, encoding=TopicInfo.ENCODING_NONE):
         """ Create a new publisher. """
         self.topic = topic
+        self.decoder = DeltaDecoder() if encoding == TopicInfo.ENCODING_DELTA else None
 
         # find message type
         package, message = message_type.split('/')
@@ -87,6 +206,11 @@ class Publisher:
 
     def handlePacket(self, data):
         """ """
+        if self.decoder != None:
+            data = self.decoder.decode(data)
+            if data == None:
+                rospy.logdebug("Dropped a delta on %s, waiting for a keyframe" % self.topic)
+                return
         m = self.message()
         m.deserialize(data)
         self.publisher.publish(m)
@@ -117,8 +241,14 @@ class Subscriber:
 
 
 class ServiceServer:
-    def __init__(self, name, service_type, parent):
-        self.name = service_name
+    """
+        Forwards calls of a ROS service to the device that provides it.
+        Each call is tagged with a request ID, so that several can be in
+        flight at once.
+    """
+    def __init__(self, topic_id, name, service_type, parent):
+        self.topic_id = topic_id
+        self.name = name
         self.service_type = service_type
         self.parent = parent
 
@@ -127,18 +257,101 @@ class ServiceServer:
         m = load_pkg_module(package)
 
         srvs = getattr(m, 'srv')
-        self.srv_req = getattr(srvs, message+"Request")
         self.srv_resp = getattr(srvs, message+"Response")
         self.srv = getattr(srvs, message)
-        self.service = rospy.Service(self.service_name, self.srv, self.callback)
-        self.response = None
+        self.lock = threading.Condition()
+        self.next_request_id = 0
+        self.responses = dict() #request id -> response, None until it arrives
+        self.service = rospy.Service(self.name, self.srv, self.callback)
+
     def handlePacket(self, data):
-        resp = self.srv_resp()
-        resp.deserialize(data)
-        self.response = resp
-    def callback(self, msg):
-        msg.serialize(data_buffer)
-        self.parent.send(self.parent.services[self.name][0], data_buffer.getvalue())
+        """ Hand a response from the device to the call waiting for it. """
+        if len(data) < 3:
+            rospy.logerr("%s: truncated response" % self.name)
+            return
+        request_id, success = struct.unpack("<HB", data[:3])
+        self.lock.acquire()
+        try:
+            if request_id not in self.responses:
+                rospy.logwarn("%s: response to call %d arrived too late" % (self.name, request_id))
+                return
+            if success:
+                resp = self.srv_resp()
+                resp.deserialize(data[3:])
+                self.responses[request_id] = resp
+            else:
+                self.responses[request_id] = False
+            self.lock.notifyAll()
+        finally:
+            self.lock.release()
+
+    def callback(self, req):
+        """ Forward a call to the device and wait for its response. """
+        self.lock.acquire()
+        request_id = self.next_request_id
+        self.next_request_id = (self.next_request_id + 1) % 65536
+        self.responses[request_id] = None
+        self.lock.release()
+
+        data_buffer = StringIO.StringIO()
+        req.serialize(data_buffer)
+        self.parent.send(self.topic_id, struct.pack("<H", request_id) + data_buffer.getvalue())
+
+        deadline = time.time() + self.parent.timeout
+        self.lock.acquire()
+        try:
+            while self.responses[request_id] == None and time.time() < deadline:
+                self.lock.wait(deadline - time.time())
+            resp = self.responses.pop(request_id)
+        finally:
+            self.lock.release()
+        if resp == None:
+            raise rospy.ServiceException("%s: no response from the device" % self.name)
+        if resp == False:
+            raise rospy.ServiceException("%s: the device failed the call" % self.name)
+        return resp
+
+
+class ServiceClient:
+    """
+        Calls a ROS service for the device. Each call runs in its own
+        thread and is answered with the request ID the device sent.
+    """
+    def __init__(self, topic_id, name, service_type, parent):
+        self.topic_id = topic_id
+        self.name = name
+        self.service_type = service_type
+        self.parent = parent
+
+        # find message type
+        package, message = self.service_type.split('/')
+        m = load_pkg_module(package)
+
+        srvs = getattr(m, 'srv')
+        self.srv_req = getattr(srvs, message+"Request")
+        self.srv = getattr(srvs, message)
+
+    def handlePacket(self, data):
+        """ Start the call requested by the device. """
+        if len(data) < 2:
+            rospy.logerr("%s: truncated request" % self.name)
+            return
+        request_id, = struct.unpack("<H", data[:2])
+        req = self.srv_req()
+        req.deserialize(data[2:])
+        thread.start_new_thread(self.call, (request_id, req))
+
+    def call(self, request_id, req):
+        """ Make one call and send its response to the device. """
+        try:
+            resp = rospy.ServiceProxy(self.name, self.srv)(req)
+        except Exception as e:
+            rospy.logerr("%s: call failed: %s" % (self.name, e))
+            self.parent.send(self.topic_id, struct.pack("<HB", request_id, 0))
+            return
+        data_buffer = StringIO.StringIO()
+        resp.serialize(data_buffer)
+        self.parent.send(self.topic_id, struct.pack("<HB", request_id, 1) + data_buffer.getvalue())
 
 
 class SerialClient:
@@ -146,12 +359,26 @@ class SerialClient:
         Prototype of rosserial python client to connect to serial bus.
     """
 
-    def __init__(self, port=None, baud=115200, timeout=5.0):
-        """ Initialize node, connect to bus, attempt to negotiate topics. """
+    def __init__(self, port=None, baud=115200, timeout=5.0, max_frame_length=None, baud_rates=None):
+        """ Initialize node, connect to bus, attempt to negotiate topics.
+            Frames claiming more than max_frame_length payload bytes, if
+            given, are taken for noise as soon as their header arrives.
+            The link is switched to the highest of baud_rates the device
+            offers; by default BAUD_RATES for a serial port that is opened
+            here, and none for a file-like port.
+        """
         self.mutex = thread.allocate_lock()
 
         self.lastsync = rospy.Time.now()
         self.timeout = timeout
+        self.max_frame_length = max_frame_length
+        self.baud = baud #the rate the device starts at and falls back to
+        self.current_baud = baud
+        self.baud_ceiling = None #highest rate known to work, if one failed
+        self.device_baud_rates = [] #rates offered by the device
+        self.baud_pending = None #rate switched to but not confirmed yet
+        self.baud_switch_time = None
+        self.frame_errors = 0 #checksum errors since the last time sync
 
         if port== None:
             # no port specified, listen for any new port?
@@ -159,9 +386,12 @@ class SerialClient:
         elif hasattr(port, 'read'):
             #assume its a filelike object
             self.port=port
+            if baud_rates == None:
+                baud_rates = []
         else:
             # open a specific port
             self.port = Serial(port, baud, timeout=self.timeout*0.5)
+        self.baud_rates = BAUD_RATES if baud_rates == None else baud_rates
 
         self.port.timeout = 0.01 #edit the port timeout
 
@@ -169,16 +399,35 @@ class SerialClient:
                         #(Important for uno)
 
         self.senders = dict() #Publishers/ServiceServers
-        self.receivers = dict() #subscribers/serviceclients
+        self.receivers = dict() #subscribers
+        self.services = dict() #ServiceServers/ServiceClients by (kind, name),
+                               #kept across connections
+        self.topic_hash = None #hash of the complete topic table, if known
+        self.listing_hash = FNV_OFFSET_BASIS #hash of the topics listed since
+                                             #the last negotiation
+        self.log_formats = dict() #formats of binary log messages by ID, kept
+                                  #across connections like the topic hash
+        self.diagnostics_publisher = None
+        self.diagnostic_counts = dict() #error counts of the last report
 
         rospy.sleep(2.0) # TODO
         self.requestTopics()
 
     def requestTopics(self):
         """ Determine topics to subscribe/publish. """
+        if self.current_baud != self.baud:
+            # the device goes back to its starting rate when the link is lost
+            self.setPortBaud(self.baud)
+        self.baud_pending = None
         self.port.flushInput()
-        # request topic sync
-        self.port.write("\xff\xff\x00\x00\x00\x00\xff")
+        self.listing_hash = FNV_OFFSET_BASIS
+        if self.topic_hash == None:
+            # request topic sync
+            self.port.write("\xff\xff\x00\x00\x00\x00\xff")
+        else:
+            # offer the topics kept from the last connection, the device
+            # only lists its topics if they changed
+            self.send(0, struct.pack("<I", self.topic_hash))
 
     def run(self):
         """ Forward recieved messages to appropriate publisher. """
@@ -188,79 +437,239 @@ class SerialClient:
                 rospy.logerr("Lost sync with device, restarting...")
                 self.requestTopics()
                 self.lastsync = rospy.Time.now()
+            if self.baud_pending != None and (rospy.Time.now() - self.baud_switch_time).to_sec() > BAUD_SWITCH_TIMEOUT:
+                rospy.logwarn("No answer at %d baud, falling back to %d baud" % (self.baud_pending, self.baud))
+                self.baud_ceiling = self.baud_pending - 1
+                self.requestTopics()
+                self.lastsync = rospy.Time.now()
 
-            flag = [0,0]
-            flag[0]  = self.port.read(1)
-            if (flag[0] != '\xff'):
-                continue
-            flag[1] = self.port.read(1)
-            if ( flag[1] != '\xff'):
-                rospy.loginfo("Failed Packet Flags ")
+            data += self.port.read(max(1, self.port.inWaiting()))
+            data = self.parseFrames(data)
+
+    def parseFrames(self, data):
+        """ Handle the complete frames in data and return the bytes left
+            over. After a bad checksum only the first byte of the frame is
+            dropped and the rest is scanned again, so that a frame starting
+            inside the damaged one is still found.
+        """
+        while True:
+            start = data.find('\xff\xff')
+            if start < 0:
+                # keep a trailing 0xff, it may start the next frame
+                return data[-1:] if data.endswith('\xff') else ''
+            data = data[start:]
+            if len(data) < 7:
+                return data
+            topic_id, msg_length = struct.unpack("<HH", data[2:6])
+            if self.max_frame_length != None and msg_length > self.max_frame_length:
+                # a false sync marker, don't wait for its payload
+                data = data[1:]
                 continue
-            # topic id (2 bytes)
-            header = self.port.read(4)
-            if (len(header) != 4):
-                #self.port.flushInput()
+            if len(data) < msg_length + 7:
+                return data
+            if sum(map(ord, data[2:msg_length + 7])) % 256 != 255:
+                rospy.loginfo("Packet Failed :  Checksum error")
+                self.frame_errors += 1
+                data = data[1:]
                 continue
+            self.handlePacket(topic_id, data[6:msg_length + 6])
+            data = data[msg_length + 7:]
+            rospy.sleep(0.001)
+
+    def handlePacket(self, topic_id, msg):
+        """ Dispatch a packet to the handler for its topic. """
+        if topic_id == TopicInfo.ID_PUBLISHER:
+            try:
+                m = TopicInfo()
+                m.deserialize(msg)
+                encoding = listed_encoding(m, msg)
+                self.senders[m.topic_id] = Publisher(m.topic_name, m.message_type, encoding)
+                self.listing_hash = hash_topic(self.listing_hash, m.topic_id, m.topic_name, m.message_type, encoding)
+                rospy.loginfo("Setup Publisher on %s [%s]" % (m.topic_name, m.message_type) )
+            except Exception as e:
+                rospy.logerr("Failed to parse publisher: %s", e)
+        elif topic_id == TopicInfo.ID_SUBSCRIBER:
+            try:
+                m = TopicInfo()
+                m.deserialize(msg)
+                self.receivers[m.topic_name] = [m.topic_id, Subscriber(m.topic_name, m.message_type, self)]
+                self.listing_hash = hash_topic(self.listing_hash, m.topic_id, m.topic_name, m.message_type)
+                rospy.loginfo("Setup Subscriber on %s [%s]" % (m.topic_name, m.message_type))
+            except Exception as e:
+                rospy.logerr("Failed to parse subscriber. %s"%e)
+        elif topic_id == TopicInfo.ID_SERVICE_SERVER:
+            try:
+                m = TopicInfo()
+                m.deserialize(msg)
+                self.setupService(ServiceServer, m)
+                rospy.loginfo("Setup ServiceServer on %s [%s]"%(m.topic_name, m.message_type) )
+            except Exception as e:
+                rospy.logerr("Failed to parse service server: %s", e)
+        elif topic_id == TopicInfo.ID_SERVICE_CLIENT:
+            try:
+                m = TopicInfo()
+                m.deserialize(msg)
+                self.setupService(ServiceClient, m)
+                rospy.loginfo("Setup ServiceClient on %s [%s]"%(m.topic_name, m.message_type) )
+            except Exception as e:
+                rospy.logerr("Failed to parse service client: %s", e)
+
+        elif topic_id == TopicInfo.ID_PARAMETER_REQUEST:
+            self.handleParameterRequest(msg)
+        elif topic_id == TopicInfo.ID_PARAMETER_BATCH:
+            self.handleParameterBatchRequest(msg)
+
+        elif topic_id == TopicInfo.ID_TOPIC_HASH:
+            self.handleTopicHash(msg)
+
+        elif topic_id == TopicInfo.ID_LOG:
+            self.handleLogging(msg)
+        elif topic_id == TopicInfo.ID_LOG_FORMAT:
+            self.handleLogFormat(msg)
+        elif topic_id == TopicInfo.ID_BINARY_LOG:
+            self.handleBinaryLog(msg)
+
+        elif topic_id == TopicInfo.ID_DIAGNOSTICS:
+            self.handleDiagnostics(msg)
+
+        elif topic_id == TopicInfo.ID_BAUD_RATE:
+            self.handleBaudRates(msg)
+
+        elif topic_id == TopicInfo.ID_BATCH:
+            self.handleBatch(msg)
+
+        elif topic_id == TopicInfo.ID_TIME:
+            self.sendTime()
+            self.lastsync = rospy.Time.now()
+            self.checkBaud()
+        elif topic_id >= 100: # TOPIC
+            try:
+                self.senders[topic_id].handlePacket(msg)
+            except KeyError:
+                rospy.logerr("Tried to publish before configured, topic id %d" % topic_id)
+        else:
+            rospy.logerr("Unrecognized command topic!")
 
-            topic_id, msg_length = struct.unpack("<hh", header)
-            msg = self.port.read(msg_length)
-            if (len(msg) != msg_length):
-                rospy.loginfo("Packet Failed :  Failed to read msg data")
-                #self.port.flushInput()
-                continue
-            chk = self.port.read(1)
-            checksum = sum(map(ord,header) ) + sum(map(ord, msg)) + ord(chk)
-
-            if checksum%256 == 255:
-                if topic_id == TopicInfo.ID_PUBLISHER:
-                    try:
-                        m = TopicInfo()
-                        m.deserialize(msg)
-                        self.senders[m.topic_id] = Publisher(m.topic_name, m.message_type)
-                        rospy.loginfo("Setup Publisher on %s [%s]" % (m.topic_name, m.message_type) )
-                    except Exception as e:
-                        rospy.logerr("Failed to parse publisher: %s", e)
-                elif topic_id == TopicInfo.ID_SUBSCRIBER:
-                    try:
-                        m = TopicInfo()
-                        m.deserialize(msg)
-                        self.receivers[m.topic_name] = [m.topic_id, Subscriber(m.topic_name, m.message_type, self)]
-                        rospy.loginfo("Setup Subscriber on %s [%s]" % (m.topic_name, m.message_type))
-                    except Exception as e:
-                        rospy.logerr("Failed to parse subscriber. %s"%e)
-                elif topic_id == TopicInfo.ID_SERVICE_SERVER:
-                    try:
-                        m = TopicInfo()
-                        m.deserialize(msg)
-                        self.senders[m.topic_id]=ServiceServer(m.topic_name, m.message_type, self)
-                        rospy.loginfo("Setup ServiceServer on %s [%s]"%(m.topic_name, m.message_type) )
-                    except:
-                        rospy.logerr("Failed to parse service server")
-                elif topic_id == TopicInfo.ID_SERVICE_CLIENT:
-                    pass
-
-                elif topic_id == TopicInfo.ID_PARAMETER_REQUEST:
-                    self.handleParameterRequest(msg)
-
-                elif topic_id == TopicInfo.ID_LOG:
-                    self.handleLogging(msg)
-
-                elif topic_id == TopicInfo.ID_TIME:
-                    t = Time()
-                    t.data = rospy.Time.now()
-                    data_buffer = StringIO.StringIO()
-                    t.serialize(data_buffer)
-                    self.send( TopicInfo.ID_TIME, data_buffer.getvalue() )
-                    self.lastsync = rospy.Time.now()
-                elif topic_id >= 100: # TOPIC
-                    try:
-                        self.senders[topic_id].handlePacket(msg)
-                    except KeyError:
-                        rospy.logerr("Tried to publish before configured, topic id %d" % topic_id)
-                else:
-                    rospy.logerr("Unrecognized command topic!")
-                rospy.sleep(0.001)
+    def sendTime(self):
+        t = Time()
+        t.data = rospy.Time.now()
+        data_buffer = StringIO.StringIO()
+        t.serialize(data_buffer)
+        self.send( TopicInfo.ID_TIME, data_buffer.getvalue() )
+
+    def handleBaudRates(self, data):
+        """ The device offers its baud rates after topic negotiation, and
+            only those below the current one when it sees too many errors.
+        """
+        rates = list(struct.unpack("<%dI" % (len(data) / 4), data[:len(data) / 4 * 4]))
+        if rates and max(rates) < self.current_baud:
+            self.baud_ceiling = self.current_baud - 1
+        self.device_baud_rates = rates
+        self.negotiateBaud()
+
+    def negotiateBaud(self):
+        """ Switch to the highest rate both sides support that has not
+            failed before, or back to the starting rate if there is none.
+        """
+        rates = [r for r in self.device_baud_rates if r in self.baud_rates and
+                 (self.baud_ceiling == None or r <= self.baud_ceiling)]
+        rate = max(rates) if rates else self.baud
+        if rate == self.current_baud:
+            return
+        rospy.loginfo("Switching to %d baud" % rate)
+        self.send(TopicInfo.ID_BAUD_RATE, struct.pack("<I", rate))
+        # let the command go out at the old rate before switching
+        self.port.flush()
+        time.sleep(0.05)
+        self.setPortBaud(rate)
+        self.port.flushInput()
+        self.baud_pending = rate if rate != self.baud else None
+        self.baud_switch_time = rospy.Time.now()
+        # tells the device it is heard, it then requests a time sync
+        self.sendTime()
+
+    def checkBaud(self):
+        """ On every time sync, confirm a switch to a new baud rate, or step
+            down from a rate that shows too many checksum errors.
+        """
+        if self.baud_pending != None:
+            rospy.loginfo("Switched to %d baud" % self.baud_pending)
+            self.baud_pending = None
+        elif self.current_baud != self.baud and self.frame_errors > BAUD_ERROR_THRESHOLD:
+            rospy.logwarn("%d checksum errors at %d baud, lowering the rate" % (self.frame_errors, self.current_baud))
+            self.baud_ceiling = self.current_baud - 1
+            self.negotiateBaud()
+        self.frame_errors = 0
+
+    def setPortBaud(self, rate):
+        self.port.baudrate = rate
+        self.current_baud = rate
+
+    def setupService(self, kind, m):
+        """ Forward the service listed in m, reusing the proxy from an
+            earlier listing since a ROS service can only be registered once.
+            A device may serve and call a service of the same name, so
+            servers and clients are kept apart.
+        """
+        key = (kind, m.topic_name)
+        service = self.services.get(key)
+        if service != None and service.service_type == m.message_type:
+            service.topic_id = m.topic_id
+        else:
+            if service != None and kind == ServiceServer:
+                # The server's type changed; free the name for the new one.
+                service.service.shutdown()
+            service = kind(m.topic_id, m.topic_name, m.message_type, self)
+            self.services[key] = service
+        self.senders[m.topic_id] = service
+        self.listing_hash = hash_topic(self.listing_hash, m.topic_id, m.topic_name, m.message_type)
+
+    def handleTopicHash(self, data):
+        """ Keep the topic table for the next connection once the device
+            has confirmed that it is complete.
+        """
+        m = UInt32()
+        m.deserialize(data)
+        if m.data == self.topic_hash:
+            rospy.loginfo("Topics unchanged since the last connection")
+        elif m.data == self.listing_hash:
+            self.topic_hash = m.data
+        else:
+            rospy.logwarn("Topic listing incomplete, it will be requested again on reconnect")
+            self.topic_hash = None
+
+    def handleBatch(self, data):
+        """ Dispatch each (topic, length, payload) record of a batch. """
+        offset = 0
+        while offset + 4 <= len(data):
+            topic_id, msg_length = struct.unpack("<HH", data[offset:offset+4])
+            offset += 4
+            if offset + msg_length > len(data):
+                rospy.logerr("Batched packet truncated")
+                return
+            self.handlePacket(topic_id, data[offset:offset+msg_length])
+            offset += msg_length
+
+    def lookupParameter(self, name):
+        """Returns the value of parameter name as a list of ints, floats
+            or strings, and its type, or (None, None) if it cannot be sent.
+        """
+        param = rospy.get_param(name, None)
+        if param == None:
+            rospy.logerr("Parameter %s does not exist"%name)
+            return None, None
+        if (type(param) == dict):
+            rospy.logerr("Cannot send param %s because it is a dictionary"%name)
+            return None, None
+        if (type(param) != list):
+            param = [param]
+        #check to make sure that all parameters in list are same type
+        t = type(param[0])
+        for p in param:
+            if t!= type(p):
+                rospy.logerr('All Paramers in the list %s must be of the same type'%name)
+                return None, None
+        return param, t
 
     def handleParameterRequest(self,data):
         """Handlers the request for parameters from the rosserial_client
@@ -271,21 +680,9 @@ class SerialClient:
         req = RequestParamRequest()
         req.deserialize(data)
         resp = RequestParamResponse()
-        param = rospy.get_param(req.name, None)
+        param, t = self.lookupParameter(req.name)
         if param == None:
-            rospy.logerr("Parameter %s does not exist"%req.name)
-            return
-        if (type(param) == dict):
-            rospy.logerr("Cannot send param %s because it is a dictionary"%req.name)
             return
-        if (type(param) != list):
-            param = [param]
-        #check to make sure that all parameters in list are same type
-        t = type(param[0])
-        for p in param:
-            if t!= type(p):
-                rospy.logerr('All Paramers in the list %s must be of the same type'%req.name)
-                return
         if (t == int):
             resp.ints= param
         if (t == float):
@@ -296,19 +693,143 @@ class SerialClient:
         resp.serialize(data_buffer)
         self.send(TopicInfo.ID_PARAMETER_REQUEST, data_buffer.getvalue())
 
+    def handleParameterBatchRequest(self, data):
+        """Answers a batch of parameter requests with one reply, so that
+            the client can fill its parameter cache at once. Parameters
+            that cannot be sent are reported as TYPE_NONE.
+        """
+        req = RequestParamsRequest()
+        req.deserialize(data)
+        resp = RequestParamsResponse()
+        # uint8[] fields start out as str, so collect them in lists first
+        types = []
+        lengths = []
+        for name in req.names:
+            param, t = self.lookupParameter(name)
+            if (t == int):
+                types.append(RequestParamsResponse.TYPE_INT)
+                resp.ints.extend(param)
+            elif (t == float):
+                types.append(RequestParamsResponse.TYPE_FLOAT)
+                resp.floats.extend(param)
+            elif (t == str):
+                types.append(RequestParamsResponse.TYPE_STRING)
+                resp.strings.extend(param)
+            else:
+                types.append(RequestParamsResponse.TYPE_NONE)
+                param = []
+            lengths.append(len(param))
+        resp.types = types
+        resp.lengths = lengths
+        data_buffer = StringIO.StringIO()
+        resp.serialize(data_buffer)
+        self.send(TopicInfo.ID_PARAMETER_BATCH, data_buffer.getvalue())
+
     def handleLogging(self, data):
         m= Log()
         m.deserialize(data)
-        if (m.level == Log.DEBUG):
-            rospy.logdebug(m.msg)
-        elif(m.level== Log.INFO):
-            rospy.loginfo(m.msg)
-        elif(m.level== Log.WARN):
-            rospy.logwarn(m.msg)
-        elif(m.level== Log.ERROR):
-            rospy.logerr(m.msg)
-        elif(m.level==Log.FATAL):
-            rospy.logfatal(m.msg)
+        self.log(m.level, m.msg)
+
+    def handleLogFormat(self, data):
+        """ Register a format of binary log messages: its 16 bit ID
+            followed by the format string.
+        """
+        if len(data) < 2:
+            return
+        format_id = struct.unpack("<H", data[:2])[0]
+        self.log_formats[format_id] = compile_log_format(data[2:])
+        self.listing_hash = hash_topic(self.listing_hash, format_id, data[2:], "")
+
+    def handleBinaryLog(self, data):
+        """ Format a binary log message, the level, the ID of its format
+            and the raw arguments, and forward it to rosout.
+        """
+        try:
+            level, format_id = struct.unpack("<BH", data[:3])
+            format, codes = self.log_formats[format_id]
+            args = []
+            offset = 3
+            for code in codes:
+                if code == "s":
+                    end = data.find("\0", offset)
+                    if end < 0:
+                        end = len(data)
+                    args.append(data[offset:end])
+                    offset = end + 1
+                else:
+                    args.append(struct.unpack_from("<" + code, data, offset)[0])
+                    offset += 4
+            self.log(level, format % tuple(args))
+        except KeyError:
+            rospy.logerr("Binary log message with unknown format %d" % format_id)
+        except (struct.error, TypeError, ValueError) as e:
+            rospy.logerr("Failed to format binary log message: %s" % e)
+
+    def log(self, level, msg):
+        if (level == Log.DEBUG):
+            rospy.logdebug(msg)
+        elif(level== Log.INFO):
+            rospy.loginfo(msg)
+        elif(level== Log.WARN):
+            rospy.logwarn(msg)
+        elif(level== Log.ERROR):
+            rospy.logerr(msg)
+        elif(level==Log.FATAL):
+            rospy.logfatal(msg)
+
+    def handleDiagnostics(self, data):
+        """ Republish the link statistics of a client built with
+            ROSSERIAL_DIAGNOSTICS on /diagnostics. The link and each topic
+            get a status, which is WARN while their error or drop counts
+            grow from one report to the next.
+        """
+        m = LinkStatistics()
+        m.deserialize(data)
+        if self.diagnostics_publisher == None:
+            self.diagnostics_publisher = rospy.Publisher("/diagnostics", DiagnosticArray)
+        hardware_id = str(getattr(self.port, "port", ""))
+
+        link = DiagnosticStatus(name="rosserial link", hardware_id=hardware_id)
+        errors = [("invalid size errors", m.invalid_size_errors),
+                  ("checksum errors", m.checksum_errors),
+                  ("state errors", m.state_errors),
+                  ("malformed message errors", m.malformed_message_errors),
+                  ("tx dropped frames", m.tx_dropped_frames)]
+        link.level, link.message = self.diagnosticLevel("link",
+            sum([count for label, count in errors]), "Errors on the link")
+        link.values = [KeyValue(label, str(count)) for label, count in errors]
+        link.values.append(KeyValue("tx high water mark", str(m.tx_high_water_mark)))
+        link.values.append(KeyValue("round trip time us", str(m.round_trip_time)))
+        link.values.extend(histogram_values("spin time", m.spin_time))
+        link.values.extend(histogram_values("callback time", m.callback_time))
+
+        names = dict([(v[0], name) for name, v in self.receivers.items()])
+        for topic_id, sender in self.senders.items():
+            names[topic_id] = getattr(sender, "topic", getattr(sender, "name", ""))
+        array = DiagnosticArray()
+        array.header.stamp = rospy.Time.now()
+        array.status.append(link)
+        for topic in m.topics:
+            name = names.get(topic.topic_id, "topic %d" % topic.topic_id)
+            status = DiagnosticStatus(name="rosserial topic %s" % name, hardware_id=hardware_id)
+            status.level, status.message = self.diagnosticLevel(topic.topic_id,
+                topic.dropped, "Frames dropped")
+            status.values = [KeyValue("topic id", str(topic.topic_id)),
+                             KeyValue("frames", str(topic.frames)),
+                             KeyValue("bytes", str(topic.bytes)),
+                             KeyValue("dropped", str(topic.dropped))]
+            array.status.append(status)
+        self.diagnostics_publisher.publish(array)
+
+    def diagnosticLevel(self, key, count, problem):
+        """ WARN and the problem if count grew since the last report for
+            key, else OK.
+        """
+        last = self.diagnostic_counts.get(key, 0)
+        self.diagnostic_counts[key] = count
+        if count > last:
+            return DiagnosticStatus.WARN, problem
+        return DiagnosticStatus.OK, "OK"
 
     def send(self, topic, msg):
         """ Send a message on a particular topic to the device. """
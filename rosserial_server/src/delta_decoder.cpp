@@ -0,0 +1,83 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "delta_decoder.h"
+
+namespace rosserial_server {
+
+DeltaDecoder::DeltaDecoder() : valid_(false), sequence_(0) {}
+
+const std::vector<uint8_t>* DeltaDecoder::decode(const uint8_t* data, int length) {
+  if (length < 2) {
+    valid_ = false;
+    return 0;
+  }
+  uint8_t kind = data[0];
+  uint8_t sequence = data[1];
+  if (kind == kKeyframe) {
+    sample_.assign(data + 2, data + length);
+    valid_ = true;
+  } else if (kind == kDelta && valid_ && sequence == static_cast<uint8_t>(sequence_ + 1)) {
+    valid_ = applyDelta(data + 2, length - 2);
+  } else {
+    valid_ = false;
+  }
+  sequence_ = sequence;
+  return valid_ ? &sample_ : 0;
+}
+
+bool DeltaDecoder::applyDelta(const uint8_t* delta, int length) {
+  int i = 0;
+  int offset = 0;
+  while (offset < length) {
+    if (offset + 2 > length) {
+      return false;
+    }
+    int unchanged = delta[offset];
+    int changed = delta[offset + 1];
+    offset += 2;
+    i += unchanged;
+    if (i + changed > static_cast<int>(sample_.size()) || offset + changed > length) {
+      return false;
+    }
+    for (int j = 0; j < changed; j++) {
+      sample_[i + j] ^= delta[offset + j];
+    }
+    i += changed;
+    offset += changed;
+  }
+  return true;
+}
+
+}  // namespace rosserial_server
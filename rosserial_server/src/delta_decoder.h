@@ -0,0 +1,75 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSSERIAL_SERVER_DELTA_DECODER_H_
+#define ROSSERIAL_SERVER_DELTA_DECODER_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+namespace rosserial_server {
+
+// Rebuilds the samples of a topic listed with ENCODING_DELTA, as
+// rosserial_client's DeltaFrame sends them:
+//
+//   0 sequence message
+//   1 sequence (unchanged changed changed_bytes)...
+//
+// A keyframe holds the whole serialized sample. A delta holds its XOR with
+// the previous sample as pairs of runs: unchanged bytes to skip, then
+// changed bytes. After a missed sequence number or a malformed delta,
+// samples are dropped until the next keyframe.
+class DeltaDecoder {
+ public:
+  DeltaDecoder();
+
+  // Returns the sample in data, or 0 if it can't be rebuilt. The sample is
+  // valid until the next call.
+  const std::vector<uint8_t>* decode(const uint8_t* data, int length);
+
+ private:
+  static const uint8_t kKeyframe = 0;
+  static const uint8_t kDelta = 1;
+
+  std::vector<uint8_t> sample_;
+  bool valid_;
+  uint8_t sequence_;
+
+  bool applyDelta(const uint8_t* delta, int length);
+};
+
+}  // namespace rosserial_server
+
+#endif  // ROSSERIAL_SERVER_DELTA_DECODER_H_
@@ -0,0 +1,178 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "frame_parser.h"
+
+namespace rosserial_server {
+
+FrameParser::FrameParser(Handler* handler)
+    : handler_(handler),
+      state_(STATE_FIRST_FF),
+      topic_(0),
+      remaining_(0),
+      checksum_(0),
+      max_payload_length_(0xffff),
+      checksum_error_count_(0),
+      sync_error_count_(0) {
+  header_[0] = 0xff;
+  header_[1] = 0xff;
+}
+
+void FrameParser::parse(const uint8_t* data, int length) {
+  int i = 0;
+  while (i < length) {
+    if (state_ == STATE_FIRST_FF) {
+      int used = parseWhole(data + i, length - i);
+      if (used > 0) {
+        i += used;
+        continue;
+      }
+    }
+    if (state_ == STATE_MESSAGE) {
+      int span = length - i < remaining_ ? length - i : remaining_;
+      payload_.insert(payload_.end(), data + i, data + i + span);
+      for (int k = i; k < i + span; k++) {
+        checksum_ += data[k];
+      }
+      i += span;
+      remaining_ -= span;
+      if (remaining_ == 0) {
+        state_ = STATE_CHECKSUM;
+      }
+      continue;
+    }
+    uint8_t byte = data[i++];
+    switch (state_) {
+      case STATE_FIRST_FF:
+        if (byte == 0xff) {
+          state_ = STATE_SECOND_FF;
+        } else {
+          ++sync_error_count_;
+        }
+        break;
+      case STATE_SECOND_FF:
+        if (byte == 0xff) {
+          state_ = STATE_TOPIC_LOW;
+        } else {
+          ++sync_error_count_;
+          state_ = STATE_FIRST_FF;
+        }
+        break;
+      case STATE_TOPIC_LOW:
+        header_[2] = byte;
+        topic_ = byte;
+        checksum_ = byte;
+        state_ = STATE_TOPIC_HIGH;
+        break;
+      case STATE_TOPIC_HIGH:
+        header_[3] = byte;
+        topic_ |= byte << 8;
+        checksum_ += byte;
+        state_ = STATE_SIZE_LOW;
+        break;
+      case STATE_SIZE_LOW:
+        header_[4] = byte;
+        remaining_ = byte;
+        checksum_ += byte;
+        state_ = STATE_SIZE_HIGH;
+        break;
+      case STATE_SIZE_HIGH:
+        header_[5] = byte;
+        remaining_ |= byte << 8;
+        checksum_ += byte;
+        payload_.clear();
+        if (remaining_ > max_payload_length_) {
+          ++sync_error_count_;
+          rescan();
+          break;
+        }
+        state_ = remaining_ > 0 ? STATE_MESSAGE : STATE_CHECKSUM;
+        break;
+      case STATE_CHECKSUM:
+        state_ = STATE_FIRST_FF;
+        if (static_cast<uint8_t>(checksum_ + byte) != 255) {
+          ++checksum_error_count_;
+          payload_.push_back(byte);
+          rescan();
+          break;
+        }
+        handler_->handleFrame(topic_, payload_.empty() ? 0 : &payload_[0], payload_.size());
+        break;
+      default:
+        reset();
+        break;
+    }
+  }
+}
+
+void FrameParser::reset() {
+  state_ = STATE_FIRST_FF;
+  payload_.clear();
+}
+
+int FrameParser::parseWhole(const uint8_t* data, int length) {
+  if (length <= kHeaderSize || data[0] != 0xff || data[1] != 0xff) {
+    return 0;
+  }
+  int payload_length = data[4] | data[5] << 8;
+  if (payload_length > max_payload_length_) {
+    ++sync_error_count_;
+    return 1;
+  }
+  int frame_length = kHeaderSize + payload_length + 1;
+  if (frame_length > length) {
+    return 0;
+  }
+  uint8_t checksum = 0;
+  for (int i = 2; i < frame_length; i++) {
+    checksum += data[i];
+  }
+  if (checksum != 255) {
+    // Skip only the first sync byte, the next frame may start inside
+    // this one.
+    ++checksum_error_count_;
+    return 1;
+  }
+  handler_->handleFrame(data[2] | data[3] << 8, data + kHeaderSize, payload_length);
+  return frame_length;
+}
+
+void FrameParser::rescan() {
+  std::vector<uint8_t> frame(header_ + 1, header_ + kHeaderSize);
+  frame.insert(frame.end(), payload_.begin(), payload_.end());
+  reset();
+  parse(&frame[0], frame.size());
+}
+
+}  // namespace rosserial_server
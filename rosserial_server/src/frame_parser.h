@@ -0,0 +1,121 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSSERIAL_SERVER_FRAME_PARSER_H_
+#define ROSSERIAL_SERVER_FRAME_PARSER_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+namespace rosserial_server {
+
+// Splits the byte stream from a rosserial client into frames, as written
+// by NodeOutput:
+//
+//   0xff 0xff topic_low topic_high length_low length_high payload checksum
+//
+// where the checksum makes the sum of the topic, length, payload and
+// checksum bytes 255 modulo 256. Input is taken in whatever chunks the port
+// returns. Frames that lie whole within a chunk are handed over in place;
+// only frames split across chunks are copied. After a bad checksum the
+// bytes of the frame after its first are scanned again, so that a frame
+// starting inside a damaged one is still found.
+class FrameParser {
+ public:
+  class Handler {
+   public:
+    virtual ~Handler() {}
+    // Called for every frame with a valid checksum. data is only valid
+    // during the call.
+    virtual void handleFrame(int topic_id, const uint8_t* data, int length) = 0;
+  };
+
+  explicit FrameParser(Handler* handler);
+
+  void parse(const uint8_t* data, int length);
+  // Drops any partially received frame.
+  void reset();
+  // Headers claiming a longer payload are taken for noise at once rather
+  // than after length more bytes, which a false sync marker would
+  // otherwise swallow. No limit by default.
+  void setMaxPayloadLength(int length) { max_payload_length_ = length; }
+
+  int getChecksumErrorCount() const { return checksum_error_count_; }
+  // Bytes skipped while looking for the start of a frame, and headers
+  // over the payload limit.
+  int getSyncErrorCount() const { return sync_error_count_; }
+
+ private:
+  enum State {
+    STATE_FIRST_FF,
+    STATE_SECOND_FF,
+    STATE_TOPIC_LOW,
+    STATE_TOPIC_HIGH,
+    STATE_SIZE_LOW,
+    STATE_SIZE_HIGH,
+    STATE_MESSAGE,
+    STATE_CHECKSUM,
+  };
+
+  // Bytes before the payload.
+  static const int kHeaderSize = 6;
+
+  Handler* handler_;
+  State state_;
+  int topic_;
+  int remaining_;
+  uint8_t checksum_;
+  int max_payload_length_;
+  // Header of the frame being received, for rescan().
+  uint8_t header_[kHeaderSize];
+  std::vector<uint8_t> payload_;
+  int checksum_error_count_;
+  int sync_error_count_;
+
+  // Handles a frame that starts at data and lies whole within length
+  // bytes. Returns the bytes it took, 1 if it failed its checksum or
+  // length limit, or 0 if there is no such frame.
+  int parseWhole(const uint8_t* data, int length);
+  // Parses the bytes of the split frame received so far again, from its
+  // second, after it failed.
+  void rescan();
+
+  FrameParser(const FrameParser&);
+  void operator=(const FrameParser&);
+};
+
+}  // namespace rosserial_server
+
+#endif  // ROSSERIAL_SERVER_FRAME_PARSER_H_
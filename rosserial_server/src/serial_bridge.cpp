@@ -0,0 +1,701 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "serial_bridge.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <boost/bind.hpp>
+#include <diagnostic_msgs/DiagnosticArray.h>
+#include <XmlRpcValue.h>
+
+#include "rosserial_msgs/LinkStatistics.h"
+#include "rosserial_msgs/Log.h"
+#include "rosserial_msgs/RequestParam.h"
+#include "rosserial_msgs/RequestParams.h"
+#include "rosserial_msgs/TopicInfo.h"
+#include "std_msgs/Time.h"
+#include "std_msgs/UInt32.h"
+
+namespace rosserial_server {
+
+namespace {
+
+using diagnostic_msgs::DiagnosticStatus;
+using rosserial_msgs::RequestParamsResponse;
+using rosserial_msgs::TopicInfo;
+
+const uint32_t kFnvPrime = 16777619u;
+const int kQueueSize = 10;
+
+template<class M>
+bool deserializeMessage(const uint8_t* data, int length, M* message) {
+  ros::serialization::IStream stream(const_cast<uint8_t*>(data), length);
+  try {
+    ros::serialization::deserialize(stream, *message);
+  } catch (ros::serialization::StreamOverrunException& e) {
+    return false;
+  }
+  return true;
+}
+
+void addValue(DiagnosticStatus* status, const std::string& key, unsigned long value) {
+  diagnostic_msgs::KeyValue key_value;
+  key_value.key = key;
+  char text[16];
+  snprintf(text, sizeof(text), "%lu", value);
+  key_value.value = text;
+  status->values.push_back(key_value);
+}
+
+// Labels the buckets of a LinkStatistics duration histogram.
+void addHistogram(DiagnosticStatus* status, const std::string& name,
+                  const std::vector<uint32_t>& counts) {
+  for (size_t i = 0; i < counts.size(); i++) {
+    char label[48];
+    if (i == 0) {
+      snprintf(label, sizeof(label), "%s under 16 us", name.c_str());
+    } else if (i == counts.size() - 1) {
+      snprintf(label, sizeof(label), "%s %lu us and over", name.c_str(), 8ul << i);
+    } else {
+      snprintf(label, sizeof(label), "%s %lu-%lu us", name.c_str(), 8ul << i, (16ul << i) - 1);
+    }
+    addValue(status, label, counts[i]);
+  }
+}
+
+uint32_t hashBytes(uint32_t hash, const char* data, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    hash = (hash ^ static_cast<uint8_t>(data[i])) * kFnvPrime;
+  }
+  return hash;
+}
+
+// Formats the arguments of a binary log message, as rosserial_client's
+// LogRecord sends them, by the printf format they were logged with. Every
+// integer takes 4 bytes, so length modifiers are dropped. Returns false
+// if the arguments do not match the format.
+bool formatLog(const std::string& format, const uint8_t* data, int length,
+               std::string* text) {
+  int offset = 0;
+  size_t i = 0;
+  while (i < format.size()) {
+    if (format[i] != '%') {
+      text->push_back(format[i++]);
+      continue;
+    }
+    std::string spec = "%";
+    for (i++; i < format.size() && strchr("-+ #0123456789.", format[i]); i++) {
+      spec.push_back(format[i]);
+    }
+    while (i < format.size() && strchr("hlLjzt", format[i])) {
+      i++;
+    }
+    if (i == format.size()) {
+      return false;
+    }
+    char conversion = format[i++];
+    char buffer[256];
+    if (conversion == '%') {
+      text->push_back('%');
+      continue;
+    } else if (conversion == 's') {
+      if (offset >= length) {
+        return false;
+      }
+      const void* end = memchr(data + offset, 0, length - offset);
+      int size = end != 0 ? static_cast<const uint8_t*>(end) - (data + offset) : length - offset;
+      std::string arg(reinterpret_cast<const char*>(data + offset), size);
+      offset += size + 1;
+      snprintf(buffer, sizeof(buffer), (spec + 's').c_str(), arg.c_str());
+      text->append(buffer);
+      continue;
+    }
+    if (offset + 4 > length) {
+      return false;
+    }
+    uint32_t bits = data[offset] | data[offset + 1] << 8 | data[offset + 2] << 16 |
+                    static_cast<uint32_t>(data[offset + 3]) << 24;
+    offset += 4;
+    if (conversion == 'd' || conversion == 'i') {
+      snprintf(buffer, sizeof(buffer), (spec + 'l' + conversion).c_str(),
+               static_cast<long>(static_cast<int32_t>(bits)));
+    } else if (conversion == 'c') {
+      snprintf(buffer, sizeof(buffer), (spec + 'c').c_str(), static_cast<int>(bits));
+    } else if (strchr("ouxX", conversion)) {
+      snprintf(buffer, sizeof(buffer), (spec + 'l' + conversion).c_str(),
+               static_cast<unsigned long>(bits));
+    } else if (strchr("eEfFgG", conversion)) {
+      float value;
+      memcpy(&value, &bits, sizeof(value));
+      snprintf(buffer, sizeof(buffer), (spec + conversion).c_str(), value);
+    } else {
+      return false;
+    }
+    text->append(buffer);
+  }
+  return true;
+}
+
+// Appends the value of parameter name to ints, floats or strings, as
+// SerialClient.lookupParameter() reads it: a value or a list of values of
+// one type. Returns the RequestParamsResponse type of the values, or
+// TYPE_NONE if they cannot be sent.
+uint8_t lookupParameter(ros::NodeHandle& nh, const std::string& name,
+                        std::vector<int32_t>* ints, std::vector<float>* floats,
+                        std::vector<std::string>* strings) {
+  XmlRpc::XmlRpcValue param;
+  if (!nh.getParam(name, param)) {
+    ROS_ERROR("Parameter %s does not exist", name.c_str());
+    return RequestParamsResponse::TYPE_NONE;
+  }
+  if (param.getType() == XmlRpc::XmlRpcValue::TypeStruct) {
+    ROS_ERROR("Cannot send param %s because it is a dictionary", name.c_str());
+    return RequestParamsResponse::TYPE_NONE;
+  }
+  if (param.getType() != XmlRpc::XmlRpcValue::TypeArray) {
+    XmlRpc::XmlRpcValue list;
+    list.setSize(1);
+    list[0] = param;
+    param = list;
+  }
+  if (param.size() == 0) {
+    ROS_ERROR("Cannot send param %s because it is an empty list", name.c_str());
+    return RequestParamsResponse::TYPE_NONE;
+  }
+  XmlRpc::XmlRpcValue::Type type = param[0].getType();
+  for (int i = 0; i < param.size(); i++) {
+    if (param[i].getType() != type) {
+      ROS_ERROR("All Paramers in the list %s must be of the same type", name.c_str());
+      return RequestParamsResponse::TYPE_NONE;
+    }
+  }
+  switch (type) {
+    case XmlRpc::XmlRpcValue::TypeInt:
+      for (int i = 0; i < param.size(); i++) {
+        ints->push_back(static_cast<int>(param[i]));
+      }
+      return RequestParamsResponse::TYPE_INT;
+    case XmlRpc::XmlRpcValue::TypeDouble:
+      for (int i = 0; i < param.size(); i++) {
+        floats->push_back(static_cast<double>(param[i]));
+      }
+      return RequestParamsResponse::TYPE_FLOAT;
+    case XmlRpc::XmlRpcValue::TypeString:
+      for (int i = 0; i < param.size(); i++) {
+        strings->push_back(static_cast<std::string>(param[i]));
+      }
+      return RequestParamsResponse::TYPE_STRING;
+    default:
+      ROS_ERROR("Cannot send param %s because of its type", name.c_str());
+      return RequestParamsResponse::TYPE_NONE;
+  }
+}
+
+}  // namespace
+
+uint32_t hashTopic(uint32_t hash, int topic_id, const std::string& topic_name,
+                   const std::string& message_type, uint8_t encoding) {
+  char id[2] = {static_cast<char>(topic_id & 0xff), static_cast<char>(topic_id >> 8)};
+  hash = hashBytes(hash, id, 2);
+  // Names and types are hashed with their terminators, as on the client.
+  hash = hashBytes(hash, topic_name.c_str(), topic_name.size() + 1);
+  hash = hashBytes(hash, message_type.c_str(), message_type.size() + 1);
+  if (encoding != TopicInfo::ENCODING_NONE) {
+    hash = hashBytes(hash, reinterpret_cast<const char*>(&encoding), 1);
+  }
+  return hash;
+}
+
+std::map<std::string, SerialBridge::MessageInfo> SerialBridge::message_info_;
+
+SerialBridge::SerialBridge(ros::NodeHandle& nh, SerialPort* port, double timeout,
+                           const std::string& name)
+    : nh_(nh),
+      port_(port),
+      log_prefix_(name.empty() ? "" : name + ": "),
+      parser_(this),
+      timeout_(timeout),
+      last_sync_(ros::Time::now()),
+      topic_hash_(0),
+      has_topic_hash_(false),
+      listing_hash_(kFnvOffsetBasis),
+      dropped_frame_count_(0) {
+  // Longest payload the clients send, to skip false frame starts early.
+  int max_frame_length;
+  ros::NodeHandle("~").param("max_frame_length", max_frame_length, 0);
+  if (max_frame_length > 0) {
+    parser_.setMaxPayloadLength(max_frame_length);
+  }
+}
+
+void SerialBridge::requestTopics() {
+  port_->flushInput();
+  parser_.reset();
+  listing_hash_ = kFnvOffsetBasis;
+  if (has_topic_hash_) {
+    // The client only lists its topics if they changed.
+    std_msgs::UInt32 hash;
+    hash.data = topic_hash_;
+    sendMessage(0, hash);
+  } else {
+    send(0, 0, 0);
+  }
+}
+
+void SerialBridge::checkSync() {
+  ros::Time now = ros::Time::now();
+  if (now - last_sync_ > timeout_) {
+    ROS_ERROR("%sLost sync with device, restarting...", log_prefix_.c_str());
+    requestTopics();
+    last_sync_ = now;
+  }
+}
+
+void SerialBridge::receive(const uint8_t* data, int length) {
+  parser_.parse(data, length);
+}
+
+void SerialBridge::handleFrame(int topic_id, const uint8_t* data, int length) {
+  if (topic_id >= 100) {
+    std::map<int, Publisher>::iterator it = publishers_.find(topic_id);
+    if (it == publishers_.end()) {
+      if (services_.count(topic_id)) {
+        return;
+      }
+      ROS_ERROR("%sTried to publish before configured, topic id %d", log_prefix_.c_str(),
+                topic_id);
+      return;
+    }
+    if (it->second.encoding == TopicInfo::ENCODING_DELTA) {
+      const std::vector<uint8_t>* sample = it->second.decoder.decode(data, length);
+      if (sample == 0) {
+        ROS_DEBUG("%sDropped a delta on %s, waiting for a keyframe", log_prefix_.c_str(),
+                  it->second.topic_name.c_str());
+        return;
+      }
+      length = sample->size();
+      if (length > 0) {
+        data = &(*sample)[0];
+      }
+    }
+    ros::serialization::IStream stream(const_cast<uint8_t*>(data), length);
+    it->second.message->read(stream);
+    it->second.publisher.publish(*it->second.message);
+  } else if (topic_id == TopicInfo::ID_PUBLISHER) {
+    setupPublisher(data, length);
+  } else if (topic_id == TopicInfo::ID_SUBSCRIBER) {
+    setupSubscriber(data, length);
+  } else if (topic_id == TopicInfo::ID_SERVICE_SERVER ||
+             topic_id == TopicInfo::ID_SERVICE_CLIENT) {
+    setupService(data, length);
+  } else if (topic_id == TopicInfo::ID_PARAMETER_REQUEST) {
+    handleParameterRequest(data, length);
+  } else if (topic_id == TopicInfo::ID_PARAMETER_BATCH) {
+    handleParameterBatchRequest(data, length);
+  } else if (topic_id == TopicInfo::ID_TOPIC_HASH) {
+    handleTopicHash(data, length);
+  } else if (topic_id == TopicInfo::ID_LOG) {
+    handleLogging(data, length);
+  } else if (topic_id == TopicInfo::ID_LOG_FORMAT) {
+    handleLogFormat(data, length);
+  } else if (topic_id == TopicInfo::ID_BINARY_LOG) {
+    handleBinaryLog(data, length);
+  } else if (topic_id == TopicInfo::ID_DIAGNOSTICS) {
+    handleDiagnostics(data, length);
+  } else if (topic_id == TopicInfo::ID_BAUD_RATE) {
+    // Baud rate offers are not taken up: the device only switches when told
+    // to, so it stays at the rate the port was opened with.
+  } else if (topic_id == TopicInfo::ID_BATCH) {
+    handleBatch(data, length);
+  } else if (topic_id == TopicInfo::ID_TIME) {
+    handleTime();
+  } else {
+    ROS_ERROR("%sUnrecognized command topic!", log_prefix_.c_str());
+  }
+}
+
+void SerialBridge::send(int topic_id, const uint8_t* data, int length) {
+  if (length > 0xffff) {
+    ++dropped_frame_count_;
+    return;
+  }
+  frame_.resize(length + 7);
+  frame_[0] = 0xff;
+  frame_[1] = 0xff;
+  frame_[2] = topic_id & 0xff;
+  frame_[3] = topic_id >> 8;
+  frame_[4] = length & 0xff;
+  frame_[5] = length >> 8;
+  uint8_t checksum = frame_[2] + frame_[3] + frame_[4] + frame_[5];
+  for (int i = 0; i < length; i++) {
+    frame_[6 + i] = data[i];
+    checksum += data[i];
+  }
+  frame_[6 + length] = 255 - checksum;
+  if (!port_->write(&frame_[0], frame_.size())) {
+    ++dropped_frame_count_;
+    ROS_WARN_THROTTLE(1.0, "%sDropped frames to the device, %d so far", log_prefix_.c_str(),
+                      dropped_frame_count_);
+  }
+}
+
+template<class M>
+void SerialBridge::sendMessage(int topic_id, const M& message) {
+  std::vector<uint8_t> buffer(ros::serialization::serializationLength(message));
+  if (buffer.empty()) {
+    send(topic_id, 0, 0);
+    return;
+  }
+  ros::serialization::OStream stream(&buffer[0], buffer.size());
+  ros::serialization::serialize(stream, message);
+  send(topic_id, &buffer[0], buffer.size());
+}
+
+void SerialBridge::handleBatch(const uint8_t* data, int length) {
+  int offset = 0;
+  while (offset + 4 <= length) {
+    int topic_id = data[offset] | data[offset + 1] << 8;
+    int record_length = data[offset + 2] | data[offset + 3] << 8;
+    offset += 4;
+    if (offset + record_length > length) {
+      ROS_ERROR("Batched packet truncated");
+      return;
+    }
+    handleFrame(topic_id, data + offset, record_length);
+    offset += record_length;
+  }
+}
+
+void SerialBridge::setupPublisher(const uint8_t* data, int length) {
+  TopicInfo info;
+  if (!deserializeMessage(data, length, &info)) {
+    ROS_ERROR("Failed to parse publisher");
+    return;
+  }
+  std::map<int, Publisher>::iterator it = publishers_.find(info.topic_id);
+  if (it == publishers_.end() || it->second.topic_name != info.topic_name ||
+      it->second.message_type != info.message_type) {
+    const MessageInfo* message_info = getMessageInfo(info.message_type);
+    if (message_info == 0) {
+      ROS_ERROR("%sFailed to setup publisher on %s [%s]", log_prefix_.c_str(),
+                info.topic_name.c_str(), info.message_type.c_str());
+      return;
+    }
+    Publisher& publisher = publishers_[info.topic_id];
+    publisher.topic_name = info.topic_name;
+    publisher.message_type = info.message_type;
+    publisher.message.reset(new topic_tools::ShapeShifter());
+    publisher.message->morph(message_info->md5sum, info.message_type,
+                             message_info->definition, "false");
+    publisher.publisher = publisher.message->advertise(nh_, info.topic_name, kQueueSize);
+    ROS_INFO("%sSetup Publisher on %s [%s]", log_prefix_.c_str(),
+             publisher.publisher.getTopic().c_str(), info.message_type.c_str());
+  }
+  // The encoding follows the TopicInfo unless it is ENCODING_NONE.
+  int info_length = ros::serialization::serializationLength(info);
+  uint8_t encoding = length > info_length ? data[info_length] : TopicInfo::ENCODING_NONE;
+  // Deltas of an earlier listing don't apply to samples of this one.
+  Publisher& publisher = publishers_[info.topic_id];
+  publisher.encoding = encoding;
+  publisher.decoder = DeltaDecoder();
+  listing_hash_ = hashTopic(listing_hash_, info.topic_id, info.topic_name, info.message_type,
+                            encoding);
+}
+
+void SerialBridge::setupSubscriber(const uint8_t* data, int length) {
+  TopicInfo info;
+  if (!deserializeMessage(data, length, &info)) {
+    ROS_ERROR("Failed to parse subscriber");
+    return;
+  }
+  Subscriber& subscriber = subscribers_[info.topic_name];
+  subscriber.topic_id = info.topic_id;
+  if (!subscriber.subscriber || subscriber.message_type != info.message_type) {
+    subscriber.message_type = info.message_type;
+    subscriber.subscriber = nh_.subscribe<topic_tools::ShapeShifter>(
+        info.topic_name, kQueueSize,
+        boost::bind(&SerialBridge::forward, this, info.topic_name, _1));
+    ROS_INFO("%sSetup Subscriber on %s [%s]", log_prefix_.c_str(),
+             subscriber.subscriber.getTopic().c_str(), info.message_type.c_str());
+  }
+  listing_hash_ = hashTopic(listing_hash_, info.topic_id, info.topic_name, info.message_type);
+}
+
+void SerialBridge::setupService(const uint8_t* data, int length) {
+  TopicInfo info;
+  if (!deserializeMessage(data, length, &info)) {
+    ROS_ERROR("Failed to parse service");
+    return;
+  }
+  if (services_.insert(info.topic_id).second) {
+    ROS_WARN("%sServices are not supported yet, ignoring %s [%s]", log_prefix_.c_str(),
+             info.topic_name.c_str(), info.message_type.c_str());
+  }
+  listing_hash_ = hashTopic(listing_hash_, info.topic_id, info.topic_name, info.message_type);
+}
+
+void SerialBridge::handleTime() {
+  std_msgs::Time time;
+  time.data = ros::Time::now();
+  sendMessage(TopicInfo::ID_TIME, time);
+  last_sync_ = ros::Time::now();
+}
+
+void SerialBridge::handleLogging(const uint8_t* data, int length) {
+  rosserial_msgs::Log log;
+  if (!deserializeMessage(data, length, &log)) {
+    return;
+  }
+  logMessage(log.level, log.msg);
+}
+
+void SerialBridge::handleLogFormat(const uint8_t* data, int length) {
+  if (length < 2) {
+    return;
+  }
+  int format_id = data[0] | data[1] << 8;
+  std::string format(reinterpret_cast<const char*>(data + 2), length - 2);
+  log_formats_[format_id] = format;
+  listing_hash_ = hashTopic(listing_hash_, format_id, format, "");
+}
+
+void SerialBridge::handleBinaryLog(const uint8_t* data, int length) {
+  if (length < 3) {
+    return;
+  }
+  int format_id = data[1] | data[2] << 8;
+  std::map<int, std::string>::const_iterator it = log_formats_.find(format_id);
+  if (it == log_formats_.end()) {
+    ROS_ERROR("%sBinary log message with unknown format %d", log_prefix_.c_str(), format_id);
+    return;
+  }
+  std::string text;
+  if (!formatLog(it->second, data + 3, length - 3, &text)) {
+    ROS_ERROR("%sFailed to format binary log message [%s]", log_prefix_.c_str(),
+              it->second.c_str());
+    return;
+  }
+  logMessage(data[0], text);
+}
+
+void SerialBridge::logMessage(int level, const std::string& text) {
+  switch (level) {
+    case rosserial_msgs::Log::DEBUG:
+      ROS_DEBUG("%s%s", log_prefix_.c_str(), text.c_str());
+      break;
+    case rosserial_msgs::Log::INFO:
+      ROS_INFO("%s%s", log_prefix_.c_str(), text.c_str());
+      break;
+    case rosserial_msgs::Log::WARN:
+      ROS_WARN("%s%s", log_prefix_.c_str(), text.c_str());
+      break;
+    case rosserial_msgs::Log::ERROR:
+      ROS_ERROR("%s%s", log_prefix_.c_str(), text.c_str());
+      break;
+    case rosserial_msgs::Log::FATAL:
+      ROS_FATAL("%s%s", log_prefix_.c_str(), text.c_str());
+      break;
+  }
+}
+
+void SerialBridge::handleParameterRequest(const uint8_t* data, int length) {
+  rosserial_msgs::RequestParamRequest request;
+  if (!deserializeMessage(data, length, &request)) {
+    return;
+  }
+  rosserial_msgs::RequestParamResponse response;
+  if (lookupParameter(nh_, request.name, &response.ints, &response.floats,
+                      &response.strings) == RequestParamsResponse::TYPE_NONE) {
+    return;
+  }
+  sendMessage(TopicInfo::ID_PARAMETER_REQUEST, response);
+}
+
+void SerialBridge::handleParameterBatchRequest(const uint8_t* data, int length) {
+  rosserial_msgs::RequestParamsRequest request;
+  if (!deserializeMessage(data, length, &request)) {
+    return;
+  }
+  RequestParamsResponse response;
+  for (size_t i = 0; i < request.names.size(); i++) {
+    size_t count = response.ints.size() + response.floats.size() + response.strings.size();
+    uint8_t type = lookupParameter(nh_, request.names[i], &response.ints,
+                                   &response.floats, &response.strings);
+    count = response.ints.size() + response.floats.size() + response.strings.size() - count;
+    response.types.push_back(type);
+    response.lengths.push_back(count);
+  }
+  sendMessage(TopicInfo::ID_PARAMETER_BATCH, response);
+}
+
+void SerialBridge::handleTopicHash(const uint8_t* data, int length) {
+  std_msgs::UInt32 hash;
+  if (!deserializeMessage(data, length, &hash)) {
+    return;
+  }
+  if (has_topic_hash_ && hash.data == topic_hash_) {
+    ROS_INFO("%sTopics unchanged since the last connection", log_prefix_.c_str());
+  } else if (hash.data == listing_hash_) {
+    topic_hash_ = hash.data;
+    has_topic_hash_ = true;
+  } else {
+    ROS_WARN("%sTopic listing incomplete, it will be requested again on reconnect",
+             log_prefix_.c_str());
+    has_topic_hash_ = false;
+  }
+}
+
+void SerialBridge::handleDiagnostics(const uint8_t* data, int length) {
+  rosserial_msgs::LinkStatistics statistics;
+  if (!deserializeMessage(data, length, &statistics)) {
+    return;
+  }
+  if (!diagnostics_publisher_) {
+    diagnostics_publisher_ = nh_.advertise<diagnostic_msgs::DiagnosticArray>("/diagnostics", 1);
+  }
+  diagnostic_msgs::DiagnosticArray array;
+  array.header.stamp = ros::Time::now();
+
+  DiagnosticStatus link;
+  link.name = "rosserial link";
+  link.hardware_id = port_->getName();
+  link.level = diagnosticLevel(-1, statistics.invalid_size_errors + statistics.checksum_errors +
+                               statistics.state_errors + statistics.malformed_message_errors +
+                               statistics.tx_dropped_frames);
+  link.message = link.level == DiagnosticStatus::OK ? "OK" : "Errors on the link";
+  addValue(&link, "invalid size errors", statistics.invalid_size_errors);
+  addValue(&link, "checksum errors", statistics.checksum_errors);
+  addValue(&link, "state errors", statistics.state_errors);
+  addValue(&link, "malformed message errors", statistics.malformed_message_errors);
+  addValue(&link, "tx dropped frames", statistics.tx_dropped_frames);
+  addValue(&link, "tx high water mark", statistics.tx_high_water_mark);
+  addValue(&link, "round trip time us", statistics.round_trip_time);
+  addHistogram(&link, "spin time", statistics.spin_time);
+  addHistogram(&link, "callback time", statistics.callback_time);
+  array.status.push_back(link);
+
+  for (size_t i = 0; i < statistics.topics.size(); i++) {
+    const rosserial_msgs::TopicStatistics& topic = statistics.topics[i];
+    std::string name;
+    std::map<int, Publisher>::iterator publisher = publishers_.find(topic.topic_id);
+    if (publisher != publishers_.end()) {
+      name = publisher->second.topic_name;
+    }
+    for (std::map<std::string, Subscriber>::iterator it = subscribers_.begin();
+         it != subscribers_.end(); ++it) {
+      if (it->second.topic_id == topic.topic_id) {
+        name = it->first;
+      }
+    }
+    DiagnosticStatus status;
+    status.name = "rosserial topic " + name;
+    status.hardware_id = port_->getName();
+    status.level = diagnosticLevel(topic.topic_id, topic.dropped);
+    status.message = status.level == DiagnosticStatus::OK ? "OK" : "Frames dropped";
+    addValue(&status, "topic id", topic.topic_id);
+    addValue(&status, "frames", topic.frames);
+    addValue(&status, "bytes", topic.bytes);
+    addValue(&status, "dropped", topic.dropped);
+    array.status.push_back(status);
+  }
+  diagnostics_publisher_.publish(array);
+}
+
+uint8_t SerialBridge::diagnosticLevel(int key, uint32_t count) {
+  std::map<int, uint32_t>::iterator it = diagnostic_counts_.find(key);
+  bool grew = count > (it != diagnostic_counts_.end() ? it->second : 0);
+  diagnostic_counts_[key] = count;
+  return grew ? DiagnosticStatus::WARN : DiagnosticStatus::OK;
+}
+
+void SerialBridge::forward(const std::string& topic_name,
+                           const topic_tools::ShapeShifter::ConstPtr& message) {
+  std::map<std::string, Subscriber>::iterator it = subscribers_.find(topic_name);
+  if (it == subscribers_.end()) {
+    return;
+  }
+  if (message->getDataType() != it->second.message_type) {
+    ROS_WARN_THROTTLE(10.0, "Dropping %s message on %s, the device expects %s",
+                      message->getDataType().c_str(), topic_name.c_str(),
+                      it->second.message_type.c_str());
+    return;
+  }
+  std::vector<uint8_t> buffer(message->size());
+  if (buffer.empty()) {
+    send(it->second.topic_id, 0, 0);
+    return;
+  }
+  ros::serialization::OStream stream(&buffer[0], buffer.size());
+  message->write(stream);
+  send(it->second.topic_id, &buffer[0], buffer.size());
+}
+
+const SerialBridge::MessageInfo* SerialBridge::getMessageInfo(
+    const std::string& message_type) {
+  std::map<std::string, MessageInfo>::iterator it = message_info_.find(message_type);
+  if (it != message_info_.end()) {
+    return &it->second;
+  }
+  // The type comes from the device and goes into a command line.
+  for (size_t i = 0; i < message_type.size(); i++) {
+    unsigned char c = message_type[i];
+    if (!isalnum(c) && c != '_' && c != '/') {
+      return 0;
+    }
+  }
+  std::string command = "rosrun rosserial_server message_info.py " + message_type;
+  FILE* pipe = popen(command.c_str(), "r");
+  if (pipe == 0) {
+    return 0;
+  }
+  std::string output;
+  char buffer[4096];
+  size_t count;
+  while ((count = fread(buffer, 1, sizeof(buffer), pipe)) > 0) {
+    output.append(buffer, count);
+  }
+  size_t newline = output.find('\n');
+  if (pclose(pipe) != 0 || newline == std::string::npos || newline == 0) {
+    return 0;
+  }
+  MessageInfo& info = message_info_[message_type];
+  info.md5sum = output.substr(0, newline);
+  info.definition = output.substr(newline + 1);
+  return &info;
+}
+
+}  // namespace rosserial_server
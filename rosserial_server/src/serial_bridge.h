@@ -0,0 +1,166 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSSERIAL_SERVER_SERIAL_BRIDGE_H_
+#define ROSSERIAL_SERVER_SERIAL_BRIDGE_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <ros/ros.h>
+#include <topic_tools/shape_shifter.h>
+
+#include "delta_decoder.h"
+#include "frame_parser.h"
+#include "serial_port.h"
+
+namespace rosserial_server {
+
+// The host side of the rosserial protocol, as spoken by
+// rosserial_python's SerialClient: topic negotiation, time sync, logging,
+// parameters and forwarding of topic data. Topics are forwarded as
+// serialized messages, so no message type needs to be known at compile
+// time.
+class SerialBridge : public FrameParser::Handler {
+ public:
+  // The client is considered lost when it has not synced its clock for
+  // timeout seconds. Topics are set up in the namespace of nh. A non-empty
+  // name prefixes the messages logged for the client.
+  SerialBridge(ros::NodeHandle& nh, SerialPort* port, double timeout,
+               const std::string& name = "");
+
+  // Asks the client for its topics, offering the table kept from the last
+  // connection if it is known to be complete.
+  void requestTopics();
+  // Renegotiates if the client has been silent too long.
+  void checkSync();
+
+  // Parses bytes read from the port.
+  void receive(const uint8_t* data, int length);
+  virtual void handleFrame(int topic_id, const uint8_t* data, int length);
+
+  int getDroppedFrameCount() const { return dropped_frame_count_; }
+
+ private:
+  struct Publisher {
+    std::string topic_name;
+    std::string message_type;
+    ros::Publisher publisher;
+    boost::shared_ptr<topic_tools::ShapeShifter> message;
+    uint8_t encoding;
+    // Used if encoding is ENCODING_DELTA.
+    DeltaDecoder decoder;
+  };
+
+  struct Subscriber {
+    int topic_id;
+    std::string message_type;
+    ros::Subscriber subscriber;
+  };
+
+  struct MessageInfo {
+    std::string md5sum;
+    std::string definition;
+  };
+
+  ros::NodeHandle nh_;
+  SerialPort* port_;
+  std::string log_prefix_;
+  FrameParser parser_;
+  ros::Duration timeout_;
+  ros::Time last_sync_;
+  std::map<int, Publisher> publishers_;
+  std::map<std::string, Subscriber> subscribers_;
+  // Topic IDs of the services the client listed, whose frames are dropped.
+  std::set<int> services_;
+  // Formats of binary log messages by ID, kept across connections like
+  // the topic table.
+  std::map<int, std::string> log_formats_;
+  // Shared by all bridges in the process.
+  static std::map<std::string, MessageInfo> message_info_;
+  // Hash of the complete topic table, if has_topic_hash_.
+  uint32_t topic_hash_;
+  bool has_topic_hash_;
+  // Hash of the topics listed since the last negotiation request.
+  uint32_t listing_hash_;
+  std::vector<uint8_t> frame_;
+  int dropped_frame_count_;
+  ros::Publisher diagnostics_publisher_;
+  // Error counts of the last link statistics report, by topic ID, or -1
+  // for the link.
+  std::map<int, uint32_t> diagnostic_counts_;
+
+  void send(int topic_id, const uint8_t* data, int length);
+  template<class M>
+  void sendMessage(int topic_id, const M& message);
+
+  void handleBatch(const uint8_t* data, int length);
+  void setupPublisher(const uint8_t* data, int length);
+  void setupSubscriber(const uint8_t* data, int length);
+  // Services are not forwarded yet, they are only hashed so that the
+  // listing still counts as complete.
+  void setupService(const uint8_t* data, int length);
+  void handleTime();
+  void handleLogging(const uint8_t* data, int length);
+  void handleLogFormat(const uint8_t* data, int length);
+  void handleBinaryLog(const uint8_t* data, int length);
+  // Logs text at a rosserial_msgs/Log level.
+  void logMessage(int level, const std::string& text);
+  void handleParameterRequest(const uint8_t* data, int length);
+  void handleParameterBatchRequest(const uint8_t* data, int length);
+  void handleTopicHash(const uint8_t* data, int length);
+  void handleDiagnostics(const uint8_t* data, int length);
+  // WARN if count grew since the last report for key, else OK.
+  uint8_t diagnosticLevel(int key, uint32_t count);
+  void forward(const std::string& topic_name,
+               const topic_tools::ShapeShifter::ConstPtr& message);
+
+  // Reads the MD5 sum and definition of message_type, once per type.
+  const MessageInfo* getMessageInfo(const std::string& message_type);
+};
+
+// 32 bit FNV-1a, as used by rosserial_client to hash its topic table.
+const uint32_t kFnvOffsetBasis = 2166136261u;
+// The encoding is only hashed if there is one, as on the client.
+uint32_t hashTopic(uint32_t hash, int topic_id, const std::string& topic_name,
+                   const std::string& message_type, uint8_t encoding = 0);
+
+}  // namespace rosserial_server
+
+#endif  // ROSSERIAL_SERVER_SERIAL_BRIDGE_H_
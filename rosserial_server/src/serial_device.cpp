@@ -0,0 +1,95 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "serial_device.h"
+
+namespace rosserial_server {
+
+namespace {
+
+// Seconds without a time sync before the client is considered lost, as
+// for SerialClient.
+const double kSyncTimeout = 15.0;
+// Opening the port resets many Arduinos; give the bootloader time.
+const double kResetDelay = 2.0;
+
+}  // namespace
+
+SerialDevice::SerialDevice(const ros::NodeHandle& nh, const std::string& port_name,
+                           int baud, const std::string& name)
+    : nh_(nh),
+      port_name_(port_name),
+      baud_(baud),
+      name_(name),
+      negotiated_(false) {}
+
+bool SerialDevice::attach() {
+  detach();
+  if (!port_.open(port_name_, baud_)) {
+    return false;
+  }
+  bridge_.reset(new SerialBridge(nh_, &port_, kSyncTimeout, name_));
+  negotiate_time_ = ros::Time::now() + ros::Duration(kResetDelay);
+  negotiated_ = false;
+  return true;
+}
+
+void SerialDevice::detach() {
+  bridge_.reset();
+  port_.close();
+}
+
+bool SerialDevice::receive() {
+  uint8_t buffer[4096];
+  int length;
+  while ((length = port_.read(buffer, sizeof(buffer))) > 0) {
+    bridge_->receive(buffer, length);
+  }
+  return length == 0;
+}
+
+bool SerialDevice::flush() {
+  return port_.flush();
+}
+
+void SerialDevice::update() {
+  if (negotiated_) {
+    bridge_->checkSync();
+  } else if (ros::Time::now() >= negotiate_time_) {
+    bridge_->requestTopics();
+    negotiated_ = true;
+  }
+}
+
+}  // namespace rosserial_server
@@ -0,0 +1,93 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSSERIAL_SERVER_SERIAL_DEVICE_H_
+#define ROSSERIAL_SERVER_SERIAL_DEVICE_H_
+
+#include <string>
+
+#include <boost/scoped_ptr.hpp>
+#include <ros/ros.h>
+
+#include "serial_bridge.h"
+#include "serial_port.h"
+
+namespace rosserial_server {
+
+// One rosserial client on one port. The port may come and go: attach()
+// opens it and starts a fresh session, detach() closes it and takes the
+// client's topics down with it.
+class SerialDevice {
+ public:
+  // The client's topics and parameters are looked up in the namespace of
+  // nh. A non-empty name prefixes the messages logged for the client.
+  SerialDevice(const ros::NodeHandle& nh, const std::string& port_name, int baud,
+               const std::string& name = "");
+
+  const std::string& getPortName() const { return port_name_; }
+  bool isAttached() const { return bridge_.get() != 0; }
+  int getFd() const { return port_.getFd(); }
+  bool hasPendingOutput() const { return port_.hasPendingOutput(); }
+
+  // Opens the port. Topics are requested once the client had time to
+  // reset. Returns false and sets errno if the port cannot be opened.
+  bool attach();
+  void detach();
+
+  // Reads and handles all waiting input. Returns false if the port failed.
+  bool receive();
+  // Writes queued output. Returns false if the port failed.
+  bool flush();
+  // Requests the topics once the client is ready and renegotiates if it
+  // has been silent too long.
+  void update();
+
+ private:
+  ros::NodeHandle nh_;
+  std::string port_name_;
+  int baud_;
+  std::string name_;
+  SerialPort port_;
+  boost::scoped_ptr<SerialBridge> bridge_;
+  // When the topics are requested, if !negotiated_.
+  ros::Time negotiate_time_;
+  bool negotiated_;
+
+  SerialDevice(const SerialDevice&);
+  void operator=(const SerialDevice&);
+};
+
+}  // namespace rosserial_server
+
+#endif  // ROSSERIAL_SERVER_SERIAL_DEVICE_H_
@@ -0,0 +1,157 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "serial_multiplexer.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace rosserial_server {
+
+namespace {
+
+// Ports handled per epoll_wait(); more are picked up by the next one.
+const int kMaxEvents = 16;
+
+}  // namespace
+
+const double SerialMultiplexer::kAttachPeriod = 1.0;
+
+SerialMultiplexer::SerialMultiplexer() : epoll_fd_(-1) {}
+
+SerialMultiplexer::~SerialMultiplexer() {
+  if (epoll_fd_ >= 0) {
+    close(epoll_fd_);
+  }
+}
+
+bool SerialMultiplexer::init() {
+  epoll_fd_ = epoll_create(kMaxEvents);
+  return epoll_fd_ >= 0;
+}
+
+void SerialMultiplexer::addDevice(const boost::shared_ptr<SerialDevice>& device) {
+  Entry entry;
+  entry.device = device;
+  entry.events = 0;
+  entry.reported = false;
+  entries_.push_back(entry);
+}
+
+void SerialMultiplexer::spinOnce() {
+  ros::Time now = ros::Time::now();
+  for (size_t i = 0; i < entries_.size(); i++) {
+    Entry& entry = entries_[i];
+    if (!entry.device->isAttached() && now >= entry.next_attach) {
+      attach(&entry);
+    }
+    uint32_t events = entry.device->hasPendingOutput() ? EPOLLIN | EPOLLOUT : EPOLLIN;
+    if (entry.events != 0 && entry.events != events) {
+      struct epoll_event event;
+      memset(&event, 0, sizeof(event));
+      event.events = events;
+      event.data.u32 = i;
+      epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, entry.device->getFd(), &event);
+      entry.events = events;
+    }
+  }
+
+  struct epoll_event ready[kMaxEvents];
+  int count = epoll_wait(epoll_fd_, ready, kMaxEvents, kPollPeriod);
+  for (int i = 0; i < count; i++) {
+    handleEvents(&entries_[ready[i].data.u32], ready[i].events);
+  }
+  for (size_t i = 0; i < entries_.size(); i++) {
+    if (entries_[i].device->isAttached()) {
+      entries_[i].device->update();
+    }
+  }
+  ros::spinOnce();
+}
+
+void SerialMultiplexer::attach(Entry* entry) {
+  SerialDevice* device = entry->device.get();
+  entry->next_attach = ros::Time::now() + ros::Duration(kAttachPeriod);
+  if (!device->attach()) {
+    // A missing device is expected until it is plugged in; say so once.
+    if (!entry->reported) {
+      ROS_WARN("Cannot open %s: %s, waiting for it", device->getPortName().c_str(),
+               strerror(errno));
+      entry->reported = true;
+    }
+    return;
+  }
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN;
+  event.data.u32 = entry - &entries_[0];
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, device->getFd(), &event) < 0) {
+    ROS_ERROR("Cannot poll %s: %s", device->getPortName().c_str(), strerror(errno));
+    device->detach();
+    return;
+  }
+  entry->events = event.events;
+  entry->reported = false;
+  ROS_INFO("Connected on %s", device->getPortName().c_str());
+}
+
+void SerialMultiplexer::detach(Entry* entry, const char* reason) {
+  ROS_WARN("Lost %s: %s", entry->device->getPortName().c_str(), reason);
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, entry->device->getFd(), 0);
+  entry->device->detach();
+  entry->events = 0;
+  entry->next_attach = ros::Time::now() + ros::Duration(kAttachPeriod);
+}
+
+void SerialMultiplexer::handleEvents(Entry* entry, uint32_t events) {
+  if (!entry->device->isAttached()) {
+    return;
+  }
+  // Read first: a port that hangs up may still hold the client's last words.
+  if ((events & EPOLLIN) && !entry->device->receive()) {
+    detach(entry, strerror(errno));
+    return;
+  }
+  if ((events & EPOLLOUT) && !entry->device->flush()) {
+    detach(entry, strerror(errno));
+    return;
+  }
+  if (events & (EPOLLERR | EPOLLHUP)) {
+    detach(entry, "hung up");
+  }
+}
+
+}  // namespace rosserial_server
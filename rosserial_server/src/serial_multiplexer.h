@@ -0,0 +1,94 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSSERIAL_SERVER_SERIAL_MULTIPLEXER_H_
+#define ROSSERIAL_SERVER_SERIAL_MULTIPLEXER_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <ros/ros.h>
+
+#include "serial_device.h"
+
+namespace rosserial_server {
+
+// Serves any number of devices from one thread. A single epoll set waits
+// on all attached ports, and ports that are missing or failed are tried
+// again every kAttachPeriod seconds, so devices can be plugged in and out
+// while the node runs.
+class SerialMultiplexer {
+ public:
+  SerialMultiplexer();
+  ~SerialMultiplexer();
+
+  // Returns false and sets errno if the epoll set cannot be created.
+  bool init();
+  // The device is attached by the next spinOnce().
+  void addDevice(const boost::shared_ptr<SerialDevice>& device);
+
+  // Waits up to kPollPeriod milliseconds for the ports, handles what
+  // arrived and services ROS callbacks.
+  void spinOnce();
+
+ private:
+  // Milliseconds epoll may wait before ROS callbacks are serviced.
+  static const int kPollPeriod = 5;
+  static const double kAttachPeriod;
+
+  struct Entry {
+    boost::shared_ptr<SerialDevice> device;
+    // Events the port is registered for, 0 if detached.
+    uint32_t events;
+    ros::Time next_attach;
+    // Whether the last failure to attach was logged.
+    bool reported;
+  };
+
+  int epoll_fd_;
+  std::vector<Entry> entries_;
+
+  void attach(Entry* entry);
+  void detach(Entry* entry, const char* reason);
+  void handleEvents(Entry* entry, uint32_t events);
+
+  SerialMultiplexer(const SerialMultiplexer&);
+  void operator=(const SerialMultiplexer&);
+};
+
+}  // namespace rosserial_server
+
+#endif  // ROSSERIAL_SERVER_SERIAL_MULTIPLEXER_H_
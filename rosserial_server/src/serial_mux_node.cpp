@@ -0,0 +1,129 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Serves many rosserial clients from one process, each on its own port
+// and in its own namespace. Ports are listed in ~ports, either by name or
+// with their own baud rate and namespace:
+//
+//   ports:
+//     - /dev/ttyACM0
+//     - {port: /dev/serial/by-id/usb-arm, baud: 500000, namespace: arm}
+//
+// ~baud is the default baud rate. Clients without a namespace share the
+// node's. A port that is missing or unplugged is opened again once it
+// appears.
+
+#include <errno.h>
+#include <string.h>
+
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+#include <ros/ros.h>
+#include <XmlRpcValue.h>
+
+#include "serial_device.h"
+#include "serial_multiplexer.h"
+
+namespace {
+
+// Adds the device described by an entry of ~ports. Returns false if the
+// entry is malformed.
+bool addDevice(rosserial_server::SerialMultiplexer* multiplexer, ros::NodeHandle& nh,
+               XmlRpc::XmlRpcValue& entry, int default_baud) {
+  std::string port_name;
+  std::string ns;
+  int baud = default_baud;
+  if (entry.getType() == XmlRpc::XmlRpcValue::TypeString) {
+    port_name = static_cast<std::string>(entry);
+  } else if (entry.getType() == XmlRpc::XmlRpcValue::TypeStruct &&
+             entry.hasMember("port") &&
+             entry["port"].getType() == XmlRpc::XmlRpcValue::TypeString) {
+    port_name = static_cast<std::string>(entry["port"]);
+    if (entry.hasMember("baud")) {
+      if (entry["baud"].getType() != XmlRpc::XmlRpcValue::TypeInt) {
+        return false;
+      }
+      baud = static_cast<int>(entry["baud"]);
+    }
+    if (entry.hasMember("namespace")) {
+      if (entry["namespace"].getType() != XmlRpc::XmlRpcValue::TypeString) {
+        return false;
+      }
+      ns = static_cast<std::string>(entry["namespace"]);
+    }
+  } else {
+    return false;
+  }
+  ROS_INFO("Serving %s at %d baud in namespace '%s'", port_name.c_str(), baud, ns.c_str());
+  multiplexer->addDevice(boost::shared_ptr<rosserial_server::SerialDevice>(
+      new rosserial_server::SerialDevice(ros::NodeHandle(nh, ns), port_name, baud,
+                                         port_name)));
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ros::init(argc, argv, "serial_mux_node");
+  ros::NodeHandle nh;
+  ros::NodeHandle private_nh("~");
+  ROS_INFO("ROS Serial C++ Multiplexer Node");
+
+  int baud;
+  private_nh.param("baud", baud, 115200);
+  XmlRpc::XmlRpcValue ports;
+  if (!private_nh.getParam("ports", ports) ||
+      ports.getType() != XmlRpc::XmlRpcValue::TypeArray || ports.size() == 0) {
+    ROS_FATAL("~ports must list the serial ports to serve");
+    return 1;
+  }
+
+  rosserial_server::SerialMultiplexer multiplexer;
+  if (!multiplexer.init()) {
+    ROS_FATAL("Cannot poll: %s", strerror(errno));
+    return 1;
+  }
+  for (int i = 0; i < ports.size(); i++) {
+    if (!addDevice(&multiplexer, nh, ports[i], baud)) {
+      ROS_FATAL("Entry %d of ~ports needs a port name, and optionally an integer baud "
+                "and a namespace", i);
+      return 1;
+    }
+  }
+  while (ros::ok()) {
+    multiplexer.spinOnce();
+  }
+  return 0;
+}
@@ -0,0 +1,78 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// A C++ replacement for rosserial_python's serial_node. It waits on the
+// port with epoll, parses whatever has arrived in one go and forwards
+// topic data as serialized messages, so it keeps up with 1-2 Mbaud links.
+// The port is opened again whenever it reappears after being lost.
+//
+//   rosrun rosserial_server serial_node [port] _port:=/dev/ttyACM0 _baud:=115200
+
+#include <errno.h>
+#include <string.h>
+
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+#include <ros/ros.h>
+
+#include "serial_device.h"
+#include "serial_multiplexer.h"
+
+int main(int argc, char** argv) {
+  ros::init(argc, argv, "serial_node");
+  ros::NodeHandle nh;
+  ros::NodeHandle private_nh("~");
+  ROS_INFO("ROS Serial C++ Node");
+
+  std::string port_name;
+  int baud;
+  private_nh.param<std::string>("port", port_name, "/dev/ttyACM0");
+  private_nh.param("baud", baud, 115200);
+  if (argc == 2) {
+    port_name = argv[1];
+  }
+
+  rosserial_server::SerialMultiplexer multiplexer;
+  if (!multiplexer.init()) {
+    ROS_FATAL("Cannot poll: %s", strerror(errno));
+    return 1;
+  }
+  multiplexer.addDevice(boost::shared_ptr<rosserial_server::SerialDevice>(
+      new rosserial_server::SerialDevice(nh, port_name, baud)));
+  while (ros::ok()) {
+    multiplexer.spinOnce();
+  }
+  return 0;
+}
@@ -0,0 +1,193 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "serial_port.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace rosserial_server {
+
+namespace {
+
+struct BaudRate {
+  int baud;
+  speed_t speed;
+};
+
+const BaudRate kBaudRates[] = {
+  {9600, B9600},
+  {19200, B19200},
+  {38400, B38400},
+  {57600, B57600},
+  {115200, B115200},
+  {230400, B230400},
+#ifdef B460800
+  {460800, B460800},
+#endif
+#ifdef B500000
+  {500000, B500000},
+#endif
+#ifdef B921600
+  {921600, B921600},
+#endif
+#ifdef B1000000
+  {1000000, B1000000},
+#endif
+#ifdef B1500000
+  {1500000, B1500000},
+#endif
+#ifdef B2000000
+  {2000000, B2000000},
+#endif
+#ifdef B3000000
+  {3000000, B3000000},
+#endif
+#ifdef B4000000
+  {4000000, B4000000},
+#endif
+};
+
+}  // namespace
+
+SerialPort::SerialPort() : fd_(-1), pending_offset_(0) {}
+
+SerialPort::~SerialPort() {
+  close();
+}
+
+bool SerialPort::open(const std::string& name, int baud) {
+  close();
+  speed_t speed = 0;
+  bool found = false;
+  for (size_t i = 0; i < sizeof(kBaudRates) / sizeof(kBaudRates[0]); i++) {
+    if (kBaudRates[i].baud == baud) {
+      speed = kBaudRates[i].speed;
+      found = true;
+    }
+  }
+  if (!found) {
+    errno = EINVAL;
+    return false;
+  }
+  name_ = name;
+  fd_ = ::open(name.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (fd_ < 0) {
+    return false;
+  }
+  struct termios tio;
+  if (tcgetattr(fd_, &tio) < 0) {
+    close();
+    return false;
+  }
+  cfmakeraw(&tio);
+  tio.c_cflag |= CLOCAL | CREAD;
+  tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+  tio.c_cc[VMIN] = 0;
+  tio.c_cc[VTIME] = 0;
+  if (cfsetispeed(&tio, speed) < 0 || cfsetospeed(&tio, speed) < 0 ||
+      tcsetattr(fd_, TCSANOW, &tio) < 0) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void SerialPort::close() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+  pending_.clear();
+  pending_offset_ = 0;
+}
+
+int SerialPort::read(uint8_t* buffer, int size) {
+  ssize_t count = ::read(fd_, buffer, size);
+  if (count < 0) {
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? 0 : -1;
+  }
+  return count;
+}
+
+void SerialPort::flushInput() {
+  tcflush(fd_, TCIFLUSH);
+}
+
+bool SerialPort::write(const uint8_t* data, int length) {
+  if (!hasPendingOutput()) {
+    ssize_t count = ::write(fd_, data, length);
+    if (count < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        return false;
+      }
+      count = 0;
+    }
+    data += count;
+    length -= count;
+    if (length == 0) {
+      return true;
+    }
+    pending_.clear();
+    pending_offset_ = 0;
+  }
+  if (pending_.size() - pending_offset_ + length > kMaxPendingOutput) {
+    return false;
+  }
+  if (pending_offset_ > pending_.size() / 2) {
+    // Drop the written bytes rather than let the queue creep along.
+    pending_.erase(pending_.begin(), pending_.begin() + pending_offset_);
+    pending_offset_ = 0;
+  }
+  pending_.insert(pending_.end(), data, data + length);
+  return true;
+}
+
+bool SerialPort::flush() {
+  while (hasPendingOutput()) {
+    ssize_t count = ::write(fd_, &pending_[pending_offset_],
+                            pending_.size() - pending_offset_);
+    if (count < 0) {
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    pending_offset_ += count;
+  }
+  pending_.clear();
+  pending_offset_ = 0;
+  return true;
+}
+
+}  // namespace rosserial_server
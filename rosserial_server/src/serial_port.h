@@ -0,0 +1,92 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ * Copyright (c) 2011, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials provided
+ *    with the distribution.
+ *  * Neither the name of Willow Garage, Inc. nor the names of its
+ *    contributors may be used to endorse or promote prducts derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSSERIAL_SERVER_SERIAL_PORT_H_
+#define ROSSERIAL_SERVER_SERIAL_PORT_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace rosserial_server {
+
+// A serial port in raw, non-blocking mode. Writes that the port cannot
+// take at once are queued and finished by flush(), so that the caller can
+// wait for the port with epoll instead of blocking.
+class SerialPort {
+ public:
+  SerialPort();
+  ~SerialPort();
+
+  // Opens name at baud bits per second. Returns false and sets errno on
+  // failure.
+  bool open(const std::string& name, int baud);
+  void close();
+  int getFd() const { return fd_; }
+  // Name of the port last opened.
+  const std::string& getName() const { return name_; }
+
+  // Reads up to size bytes. Returns the number read, 0 if none are
+  // waiting, or -1 on error.
+  int read(uint8_t* buffer, int size);
+  // Discards any input not read yet.
+  void flushInput();
+
+  // Writes data, queueing what the port does not take at once. Returns
+  // false, dropping data, if the queue would grow beyond
+  // kMaxPendingOutput, or on error.
+  bool write(const uint8_t* data, int length);
+  // Writes queued data until the queue is empty or the port would block.
+  // Returns false on error.
+  bool flush();
+  bool hasPendingOutput() const { return pending_offset_ < pending_.size(); }
+
+ private:
+  // Enough for a second of output at 2 Mbaud.
+  static const size_t kMaxPendingOutput = 256 * 1024;
+
+  int fd_;
+  std::string name_;
+  std::vector<uint8_t> pending_;
+  // Bytes at the front of pending_ that have been written.
+  size_t pending_offset_;
+
+  SerialPort(const SerialPort&);
+  void operator=(const SerialPort&);
+};
+
+}  // namespace rosserial_server
+
+#endif  // ROSSERIAL_SERVER_SERIAL_PORT_H_
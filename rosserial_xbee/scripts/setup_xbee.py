@@ -60,6 +60,7 @@ parser = OptionParser(usage=help)
 parser.add_option('-P', '--pan_id', action="store", type="int", dest="pan_id", default=1331, help="Pan ID of the xbee network.  This ID must be the same for all XBees in your network.")
 parser.add_option('-c', '--channel', action="store", type="string", dest="channel", default="0D", help="Frequency channel for the xbee network. The channel value must be the same for all XBees in your network.")
 parser.add_option('-C', '--coordinator', action="store_true", dest="coordinator", default=False, help="Configures the XBee as Coordinator for the network.  Only make the XBee connected to the computer a coordiantor.")
+parser.add_option('-a', '--api', action="store_true", dest="api", default=False, help="Configures the XBee for API mode.  Use this for nodes that drive their XBee with ros::XBeeHardware.")
 
 
 
@@ -124,6 +125,8 @@ if __name__ == '__main__':
 	cmd = ''
 	if (opts.coordinator):
 		cmd += 'AP2,CE1,' #API mode 2, and enable coordinator
+	elif (opts.api):
+		cmd += 'AP2,' #API mode 2, for ros::XBeeHardware
 	
 	cmd += 'MY%d,'%int(args[1]) #set the xbee address
 	cmd += 'BD%d,'%baud_lookup[57600] #set the xbee to interface at 57600 baud
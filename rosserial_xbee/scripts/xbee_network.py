@@ -56,44 +56,108 @@ debug = False;
 import threading
 
 
+# Largest RF payload of a Series 1 XBee.
+XBEE_MTU = 100
+
 class FakeSerial():
+	"""
+	Serial port like end of the rosserial stream of one remote node.
+
+	RF packets from the node are reassembled into rosserial frames, and only
+	frames with a valid checksum are handed to the SerialClient. Nodes using
+	ros::XBeeHardware start every packet at a frame boundary unless the frame
+	is larger than a packet, so after damage parsing picks up again at the
+	next packet.
+	"""
 	def __init__(self, id, xbee):
 		self.rxdata =''
+		self.partial = '' #start of a frame continued in the next packet
 		self.xbee  = xbee
 		self.id = id
 		self.lock = threading.Lock()
+		self.data_ready = threading.Condition(self.lock)
 		self.timeout = 0.1
 		
 	def read(self, size = 1):
-		t= 0
-		counts = self.timeout/0.01
-		#print "s%d   %s"%(size, self.rxdata)
-		while( ( len(self.rxdata) < size ) and  (not rospy.is_shutdown()) ):
-			time.sleep(0.01)
-			t = t +1
-			if (t >  counts):
-				return ''
-			
+		deadline = time.time() + self.timeout
 		with (self.lock):
+			while len(self.rxdata) < size and not rospy.is_shutdown():
+				remaining = deadline - time.time()
+				if remaining <= 0:
+					return ''
+				self.data_ready.wait(remaining)
 			out = self.rxdata[:size]
 			self.rxdata = self.rxdata[size:]
-			
 		#print "fake out " , out
 		return out
 		
+	def inWaiting(self):
+		with (self.lock):
+			return len(self.rxdata)
+
 	def write(self, data):
 		if (debug):
 			print "Sending ", [d for d in data]
-		self.xbee.send('tx', frame_id='0', options="\x01", dest_addr=self.id,data=data)
+		for i in range(0, len(data), XBEE_MTU):
+			self.xbee.send('tx', frame_id='0', options="\x01", dest_addr=self.id,data=data[i:i+XBEE_MTU])
 		
 	def putData(self, data):
+		""" Add the payload of an RF packet from the node. """
 		with (self.lock):
-			self.rxdata = self.rxdata+data
+			frames, self.partial = reassemble(self.partial, data)
+			if frames:
+				self.rxdata = self.rxdata + frames
+				self.data_ready.notify_all()
 	
 	def flushInput(self):
-		self.rxdata = ''
+		with (self.lock):
+			self.rxdata = ''
+			self.partial = ''
 		
 
+def frame_end(data, start):
+	""" Return the end of the valid frame at start of data, or None. """
+	if len(data) - start < 6 or data[start:start+2] != '\xff\xff':
+		return None
+	length, = struct.unpack('<H', data[start+4:start+6])
+	end = start + 7 + length
+	if end > len(data) or sum(map(ord, data[start+2:end])) % 256 != 255:
+		return None
+	return end
+
+def reassemble(partial, packet):
+	"""
+	Extract the complete, valid rosserial frames from partial, the unparsed
+	rest of earlier packets, followed by packet. Returns the frames and the
+	start of an incomplete frame to keep for the next packet.
+	"""
+	if partial and frame_end(packet, 0) != None:
+		# The packet carrying the rest of the kept frame was lost.
+		partial = ''
+	data = partial + packet
+	frames = []
+	pos = 0
+	while True:
+		start = data.find('\xff\xff', pos)
+		if start < 0:
+			return ''.join(frames), data[-1:] if data.endswith('\xff') else ''
+		if len(data) - start < 6:
+			return ''.join(frames), data[start:]
+		length, = struct.unpack('<H', data[start+4:start+6])
+		if start + 7 + length > len(data):
+			return ''.join(frames), data[start:]
+		end = frame_end(data, start)
+		if end != None:
+			frames.append(data[start:end])
+			pos = end
+		elif start < len(partial):
+			# The frame kept from earlier packets is damaged; the new
+			# packet starts at a frame boundary again.
+			pos = len(partial)
+		else:
+			pos = start + 1
+
+
 if __name__== '__main__':
 	print "RosSerial Xbee Network"
 	rospy.init_node('xbee_network')